@@ -0,0 +1,102 @@
+#include <Simple2D/Engine.hpp>
+#include <Simple2D/Graphics.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+using namespace S2D;
+
+// Times Core::collide over worlds of 100 to 50,000 colliders. Nine in ten are moving boxes and
+// circles with a rigidbody, the rest static walls, spread so there are always about as many
+// neighbours per collider. The first tick builds the broadphase and is reported on its own.
+
+namespace
+{
+    constexpr uint32_t Ticks   = 120;
+    constexpr float    Spacing = 40.f; // Room per collider along each axis
+
+    double elapsed(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count() / 1e3;
+    }
+
+    void populate(Engine::Scene& scene, uint32_t count)
+    {
+        std::mt19937 random(count);
+        const float extent = std::sqrt((float)count) * Spacing;
+        std::uniform_real_distribution<float> position(0.f, extent), speed(-100.f, 100.f), unit(0.f, 1.f);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            auto entity = scene.world.entity();
+
+            Engine::Transform transform{};
+            transform.position = Math::Vec3f(position(random), position(random), 0.f);
+            entity.set<Engine::Transform>(transform);
+
+            auto* collider = entity.get_mut<Engine::Collider>();
+            collider->is_static = (i % 10 == 0);
+            if (collider->is_static || unit(random) < 0.5f)
+            {
+                collider->shape = Engine::ColliderShape::Box;
+                collider->size  = (collider->is_static ? Math::Vec2f(64.f, 16.f) : Math::Vec2f(12.f, 12.f));
+            }
+            else
+            {
+                collider->shape  = Engine::ColliderShape::Circle;
+                collider->radius = 6.f;
+            }
+            entity.modified<Engine::Collider>();
+
+            if (collider->is_static) continue;
+
+            Engine::Rigidbody rigidbody{};
+            rigidbody.velocity = Math::Vec3f(speed(random), speed(random), 0.f);
+            entity.set<Engine::Rigidbody>(rigidbody);
+        }
+    }
+
+    // What the core does with the rigidbodies after collide, so the tree has bodies to move
+    void integrate(Engine::Scene& scene)
+    {
+        scene.rigidbodies.each([](Engine::Transform& transform, Engine::Rigidbody& rigidbody)
+        {
+            transform.position += Math::Vec3f(rigidbody.velocity.x, rigidbody.velocity.y, 0.f) * (float)Engine::Time::dt;
+        });
+
+        // Nothing is listening, the collision events would pile up
+        for (auto& queue : Engine::eventBus(scene.world).queues) queue.clear();
+    }
+}
+
+int main()
+{
+    // The scene's renderer compiles its shaders, so it needs a context
+    Graphics::DrawWindow window({ 320, 240 }, "bench-collide");
+    Engine::Time::dt = 1.0 / 60.0;
+
+    std::printf("%9s %14s %14s %16s\n", "colliders", "first tick ms", "tick us", "us per collider");
+    for (const uint32_t count : { 100u, 500u, 1000u, 5000u, 10000u, 25000u, 50000u })
+    {
+        auto scene = std::make_unique<Engine::Scene>();
+        populate(*scene, count);
+
+        const auto first_start = std::chrono::high_resolution_clock::now();
+        Engine::Core::collide(scene.get());
+        const double first = elapsed(first_start);
+        integrate(*scene);
+
+        double total = 0.0;
+        for (uint32_t tick = 0; tick < Ticks; tick++)
+        {
+            const auto start = std::chrono::high_resolution_clock::now();
+            Engine::Core::collide(scene.get());
+            total += elapsed(start);
+            integrate(*scene);
+        }
+
+        std::printf("%9u %14.2f %14.1f %16.3f\n", count, first / 1e3, total / Ticks, total / Ticks / count);
+    }
+}
@@ -0,0 +1,77 @@
+#include <Simple2D/Engine.hpp>
+#include <Simple2D/Graphics.hpp>
+
+#include <chrono>
+#include <cstdio>
+
+using namespace S2D;
+
+#ifndef SOURCE_DIR
+#define SOURCE_DIR "."
+#endif
+
+// Times the script phase and a Lua system over a fixed scene: every entity runs
+// scripts/movement.lua, and bench/scripts/integrate.lua moves them all. Build it once with
+// -DS2D_LUAJIT=ON and once without to compare the two runtimes, bench/luajit_vs_puc.sh does both.
+
+namespace
+{
+    constexpr uint32_t Entities = 5000;
+    constexpr uint32_t Warmup   = 10;
+    constexpr uint32_t Ticks    = 120;
+
+    double elapsed(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count() / 1e3;
+    }
+}
+
+int main()
+{
+    // The scene's renderer compiles its shaders, so it needs a context
+    Graphics::DrawWindow window({ 320, 240 }, "bench-lua-scripts");
+    Engine::Time::dt = 1.0 / 60.0;
+
+    auto scene = std::make_unique<Engine::Scene>();
+    for (uint32_t i = 0; i < Entities; i++)
+    {
+        auto entity = scene->world.entity();
+
+        Engine::Transform transform{};
+        transform.position = Math::Vec3f((float)(i % 100) * 32.f, (float)(i / 100) * 32.f, 0.f);
+        entity.set<Engine::Transform>(transform);
+        entity.set<Engine::Rigidbody>(Engine::Rigidbody{});
+
+        entity.add<Engine::Script>();
+        Engine::loadScript(SOURCE_DIR "/scripts/movement.lua", scene->world, entity, *entity.get_mut<Engine::Script>());
+    }
+    Engine::loadSystem(SOURCE_DIR "/bench/scripts/integrate.lua", scene->world);
+
+    for (uint32_t tick = 0; tick < Warmup; tick++)
+    {
+        Engine::Core::updateScripts(scene.get());
+        Engine::Core::runSystems(scene.get());
+    }
+
+    double script_time = 0.0, system_time = 0.0;
+    for (uint32_t tick = 0; tick < Ticks; tick++)
+    {
+        const auto script_start = std::chrono::high_resolution_clock::now();
+        Engine::Core::updateScripts(scene.get());
+        script_time += elapsed(script_start);
+
+        const auto system_start = std::chrono::high_resolution_clock::now();
+        Engine::Core::runSystems(scene.get());
+        system_time += elapsed(system_start);
+    }
+
+#   ifdef S2D_LUAJIT
+    const char* runtime = "LuaJIT";
+#   else
+    const char* runtime = "PUC Lua";
+#   endif
+
+    std::printf("%s, %u entities over %u ticks\n", runtime, Entities, Ticks);
+    std::printf("  movement.lua Update   %10.1f us per tick %8.3f us per entity\n", script_time / Ticks, script_time / Ticks / Entities);
+    std::printf("  integrate.lua System  %10.1f us per tick %8.3f us per entity\n", system_time / Ticks, system_time / Ticks / Entities);
+}
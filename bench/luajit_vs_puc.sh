@@ -0,0 +1,17 @@
+#!/bin/sh
+# Builds bench-lua-scripts against PUC Lua and against LuaJIT, then runs both.
+# Usage: bench/luajit_vs_puc.sh [build directory prefix], the default is build-bench
+set -e
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+prefix=${1:-build-bench}
+
+for runtime in puc luajit; do
+    if [ "$runtime" = luajit ]; then luajit=ON; else luajit=OFF; fi
+    cmake -S "$root" -B "$prefix-$runtime" -DCMAKE_BUILD_TYPE=Release -DS2D_BENCHMARKS=ON -DS2D_LUAJIT=$luajit
+    cmake --build "$prefix-$runtime" --target bench-lua-scripts -j
+done
+
+for runtime in puc luajit; do
+    "$prefix-$runtime/bench-lua-scripts"
+done
@@ -0,0 +1,120 @@
+#include <Simple2D/Engine/Shapes.hpp>
+
+#include <fcl/fcl.h>
+
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <random>
+
+using namespace S2D;
+
+// Times the native SAT test (collideShapes) against fcl::collide over the same pairs. The pairs
+// are small bullets around bigger bodies, about half of them overlapping, which is what the
+// narrowphase mostly sees in a shooter. fcl gets the slab the engine gave it, 1 unit deep.
+
+namespace
+{
+    constexpr uint32_t Pairs  = 100000;
+    constexpr uint32_t Rounds = 10;
+
+    struct Body
+    {
+        Engine::ColliderShape shape;
+        Math::Vec2f size;
+        float radius;
+    };
+
+    struct Pair
+    {
+        Engine::Shape2D native_a, native_b;
+        fcl::Transform3f transform_a, transform_b;
+    };
+
+    std::shared_ptr<fcl::CollisionGeometryf> geometry(const Body& body)
+    {
+        if (body.shape == Engine::ColliderShape::Circle) return std::make_shared<fcl::Cylinderf>(body.radius, 1.f);
+        return std::make_shared<fcl::Boxf>(body.size.x, body.size.y, 1.f);
+    }
+
+    fcl::Transform3f place(const Math::Vec2f& position, float rotation)
+    {
+        auto transform = fcl::Transform3f::Identity();
+        transform.linear() = fcl::AngleAxisf(rotation * 3.14159265f / 180.f, fcl::Vector3f::UnitZ()).toRotationMatrix();
+        transform.translation() = fcl::Vector3f(position.x, position.y, 0.f);
+        return transform;
+    }
+
+    double elapsed(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count() / 1e3;
+    }
+
+    void run(const char* name, const Body& a, const Body& b)
+    {
+        std::mt19937 random(1234);
+        std::uniform_real_distribution<float> offset(-16.f, 16.f), angle(0.f, 360.f);
+
+        std::vector<Pair> pairs(Pairs);
+        for (auto& pair : pairs)
+        {
+            const Math::Vec2f position(offset(random), offset(random));
+            const float rotation_a = angle(random), rotation_b = angle(random);
+            pair.native_a    = Engine::makeShape(a.shape, a.size, a.radius, {}, {}, rotation_a, 1.f);
+            pair.native_b    = Engine::makeShape(b.shape, b.size, b.radius, {}, position, rotation_b, 1.f);
+            pair.transform_a = place({}, rotation_a);
+            pair.transform_b = place(position, rotation_b);
+        }
+
+        uint64_t native_hits = 0;
+        const auto native_start = std::chrono::high_resolution_clock::now();
+        for (uint32_t round = 0; round < Rounds; round++)
+            for (const auto& pair : pairs)
+            {
+                Engine::Manifold manifold;
+                native_hits += Engine::collideShapes(pair.native_a, pair.native_b, manifold);
+            }
+        const double native_time = elapsed(native_start);
+
+        // Same request as the engine's mesh path
+        fcl::CollisionRequest<float> request{0};
+        request.enable_contact = true;
+        request.num_max_contacts = std::numeric_limits<int>::max();
+
+        fcl::CollisionObjectf object_a(geometry(a)), object_b(geometry(b));
+
+        uint64_t fcl_hits = 0;
+        const auto fcl_start = std::chrono::high_resolution_clock::now();
+        for (uint32_t round = 0; round < Rounds; round++)
+            for (const auto& pair : pairs)
+            {
+                object_a.setTransform(pair.transform_a);
+                object_b.setTransform(pair.transform_b);
+
+                fcl::CollisionResult<float> result;
+                fcl_hits += (fcl::collide(&object_a, &object_b, request, result) > 0);
+            }
+        const double fcl_time = elapsed(fcl_start);
+
+        const double tests = (double)Pairs * Rounds;
+        std::printf("%-18s native %8.4f us (%5.1f%% hit)   fcl %8.4f us (%5.1f%% hit)   %5.1fx\n",
+            name,
+            native_time / tests, 100.0 * native_hits / tests,
+            fcl_time / tests,    100.0 * fcl_hits / tests,
+            fcl_time / native_time);
+    }
+}
+
+int main()
+{
+    const Body bullet_circle = { Engine::ColliderShape::Circle, {},            2.f };
+    const Body bullet_box    = { Engine::ColliderShape::Box,    { 6.f, 2.f },  0.f };
+    const Body body_circle   = { Engine::ColliderShape::Circle, {},            8.f };
+    const Body body_box      = { Engine::ColliderShape::Box,    { 16.f, 24.f }, 0.f };
+
+    std::printf("%u pairs x %u rounds, time per test\n", Pairs, Rounds);
+    run("circle vs box",    body_box,    bullet_circle);
+    run("box vs box",       body_box,    bullet_box);
+    run("circle vs circle", body_circle, bullet_circle);
+    run("box vs circle",    body_circle, bullet_box);
+}
@@ -0,0 +1,65 @@
+#include <Simple2D/Engine.hpp>
+#include <Simple2D/Engine/ThreadPool.hpp>
+#include <Simple2D/Graphics.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+using namespace S2D;
+
+#ifndef SOURCE_DIR
+#define SOURCE_DIR "."
+#endif
+
+// Times the parallel script phase over entities that each have their own runtime of
+// bench/scripts/work.lua. It runs with 1 worker and then every count up to the number of
+// hardware threads, and reports the speed-up over 1.
+
+namespace
+{
+    constexpr uint32_t Entities = 2000;
+    constexpr uint32_t Warmup   = 5;
+    constexpr uint32_t Ticks    = 60;
+}
+
+int main()
+{
+    // The scene's renderer compiles its shaders, so it needs a context
+    Graphics::DrawWindow window({ 320, 240 }, "bench-script-threads");
+
+    Engine::Script::Shared   = false;
+    Engine::Script::Parallel = true;
+
+    auto scene = std::make_unique<Engine::Scene>();
+    for (uint32_t i = 0; i < Entities; i++)
+    {
+        auto entity = scene->world.entity();
+
+        Engine::Transform transform{};
+        transform.position = Math::Vec3f((float)i, (float)i, 0.f);
+        entity.set<Engine::Transform>(transform);
+
+        entity.add<Engine::Script>();
+        Engine::loadScript(SOURCE_DIR "/bench/scripts/work.lua", scene->world, entity, *entity.get_mut<Engine::Script>());
+    }
+
+    const uint32_t hardware = std::max(std::thread::hardware_concurrency(), 1U);
+    std::printf("%u entities, a runtime each, %u hardware threads\n", Entities, hardware);
+    std::printf("%8s %12s %10s %12s\n", "threads", "tick ms", "speed-up", "efficiency");
+
+    double single = 0.0;
+    for (uint32_t threads = 1; threads <= hardware; threads++)
+    {
+        Engine::ThreadPool workers(threads);
+        for (uint32_t tick = 0; tick < Warmup; tick++) Engine::Core::updateParallel(scene.get(), workers);
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (uint32_t tick = 0; tick < Ticks; tick++) Engine::Core::updateParallel(scene.get(), workers);
+        const double time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count() / 1e6 / Ticks;
+
+        if (threads == 1) single = time;
+        std::printf("%8u %12.3f %9.2fx %11.0f%%\n", threads, time, single / time, 100.0 * single / time / threads);
+    }
+}
@@ -0,0 +1,28 @@
+-- System for the script benchmark: moves every rigidbody by its velocity, through FFI views of
+-- the columns when built with LuaJIT and column references otherwise
+
+Query = { Component.Transform, Component.Rigidbody }
+
+function System(world, iter)
+    local dt = Time.deltaTime()
+    local count = iter:count()
+
+    if ColumnView then
+        local transforms = ColumnView(iter, 1)
+        local rigidbodies = ColumnView(iter, 2)
+        for i = 0, count - 1 do
+            local position, velocity = transforms[i].position, rigidbodies[i].velocity
+            position.x = position.x + velocity.x * dt
+            position.y = position.y + velocity.y * dt
+        end
+        return
+    end
+
+    local transforms = iter:field(1)
+    local rigidbodies = iter:field(2)
+    for i = 1, count do
+        local position, velocity = transforms[i].position, rigidbodies[i].velocity
+        position.x = position.x + velocity.x * dt
+        position.y = position.y + velocity.y * dt
+    end
+end
@@ -0,0 +1,16 @@
+-- Update for the thread scaling benchmark: a component round trip and some arithmetic, about
+-- what a gameplay script does per entity
+
+function Update(world, entity)
+    local transform = entity:getComponent(Component.Transform)
+
+    local x = transform.position.x
+    local y = transform.position.y
+    for i = 1, 200 do
+        x, y = x * 0.999 + math.sin(y) * 0.01, y * 0.999 + math.cos(x) * 0.01
+    end
+
+    transform.position.x = x
+    transform.position.y = y
+    entity:setComponent(transform)
+end
@@ -0,0 +1,132 @@
+#include <Simple2D/Lua/Table.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <unordered_map>
+
+using namespace S2D;
+
+// Counts the heap allocations it takes to build the tables the bindings make most: a vector,
+// a Transform as getComponent returns it, and an array. Before is the old layout rebuilt here
+// (a shared_ptr<void> per value in an unordered_map), after is Lua::Table.
+
+static uint64_t allocations = 0;
+
+void* operator new(std::size_t size)
+{
+    allocations++;
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace Before
+{
+    struct Table
+    {
+        struct Data
+        {
+            std::shared_ptr<void> data;
+            int type;
+        };
+
+        template<typename T>
+        void set(const std::string& name, const T& value)
+        {
+            std::shared_ptr<void> ptr(new T(), [](void* ptr) { delete reinterpret_cast<T*>(ptr); });
+            *static_cast<T*>(ptr.get()) = value;
+            dictionary.insert(std::pair(name, Data{ ptr, 0 }));
+        }
+
+        std::size_t entries() const { return dictionary.size(); }
+
+        std::unordered_map<std::string, Data> dictionary;
+    };
+}
+
+namespace
+{
+    constexpr uint32_t Tables = 100000;
+
+    // Read from every table so building them can't be optimised away
+    volatile std::size_t sink = 0;
+
+    template<typename Build>
+    void run(const char* name, Build&& build)
+    {
+        const auto start_allocations = allocations;
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (uint32_t i = 0; i < Tables; i++) build((float)i);
+        const double time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+        std::printf("%-28s %8.2f allocations %10.1f ns per table\n",
+            name,
+            (allocations - start_allocations) / (double)Tables,
+            time / Tables);
+    }
+
+    std::size_t entries(const Before::Table& table) { return table.entries(); }
+    std::size_t entries(const Lua::Table& table)    { return table.getMap().size() + table.size(); }
+
+    template<typename Table>
+    Table vector(float value)
+    {
+        Table table;
+        table.set("x", (Lua::Number)value);
+        table.set("y", (Lua::Number)value);
+        table.set("z", (Lua::Number)value);
+        return table;
+    }
+
+    // Same calls as Component<Name::Transform>::getTable
+    template<typename Table>
+    Table transform(float value)
+    {
+        Table table;
+        table.set("position", vector<Table>(value));
+        table.set("rotation", (Lua::Number)value);
+        table.set("scale",    (Lua::Number)1.f);
+        return table;
+    }
+}
+
+int main()
+{
+    std::printf("%u tables each\n", Tables);
+
+    run("before: {x, y, z}", [](float value) { sink += entries(vector<Before::Table>(value)); });
+    run("after:  {x, y, z}", [](float value) { sink += entries(vector<Lua::Table>(value)); });
+    run("after:  {x, y, z} reserved", [](float value)
+    {
+        Lua::Table table;
+        table.reserve(3);
+        table.set("x", (Lua::Number)value);
+        table.set("y", (Lua::Number)value);
+        table.set("z", (Lua::Number)value);
+        sink += entries(table);
+    });
+
+    run("before: Transform", [](float value) { sink += entries(transform<Before::Table>(value)); });
+    run("after:  Transform", [](float value) { sink += entries(transform<Lua::Table>(value)); });
+
+    // The old tables had no array part, element i was the key "i"
+    run("before: 8 element array", [](float value)
+    {
+        Before::Table table;
+        for (uint32_t i = 1; i <= 8; i++) table.set(std::to_string(i), (Lua::Number)value);
+        sink += entries(table);
+    });
+    run("after:  8 element array", [](float value)
+    {
+        Lua::Table table;
+        table.reserve(8, 0);
+        for (uint32_t i = 1; i <= 8; i++) table.push((Lua::Number)value);
+        sink += entries(table);
+    });
+}
@@ -126,6 +126,9 @@ struct App : Engine::Application
 
 Engine::Application* getApplication()
 {
+    // Keep compiled scripts between runs so startup doesn't parse everything again
+    Lua::ChunkCache::instance().setDirectory(SOURCE_DIR "/.luac");
+
     /* Extract window size info from a config script */
     auto window = [&]()
     {
@@ -1,13 +1,21 @@
 #pragma once
 
 #include "Log.hpp"
+#include "Engine/Commands.hpp"
 #include "Engine/Components.hpp"
 #include "Engine/Core.hpp"
+#include "Engine/Events.hpp"
+#include "Engine/Prefabs.hpp"
 #include "Engine/Resources.hpp"
+#include "Engine/Schema.hpp"
+#include "Engine/Shapes.hpp"
 #include "Engine/Application.hpp"
 #include "Engine/LuaScene.hpp"
 
 #include "Engine/LuaLib/Entity.hpp"
+#include "Engine/LuaLib/ComponentRef.hpp"
+#include "Engine/LuaLib/System.hpp"
+#include "Engine/LuaLib/Events.hpp"
 #include "Engine/LuaLib/World.hpp"
 #include "Engine/LuaLib/Time.hpp"
 #include "Engine/LuaLib/Input.hpp"
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <flecs.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace S2D::Engine
+{
+    struct WorldHandle;
+
+    /**
+     * @brief World singleton collecting the entities scripts and collisions destroy during a frame
+     *
+     * Destroying an entity only marks it here, it keeps its components (and skips its scripts)
+     * until the buffer is flushed once per frame, where every marked entity is removed in one
+     * deferred batch. flecs hands the freed IDs back out to the next entities made, with a new
+     * generation so old handles to them read as dead.
+     *
+     * Entities are made straight away since scripts use them right after creating them, but
+     * they go through \ref createEntity, which puts them in the table holding all of their
+     * components at once instead of moving them one component at a time.
+     */
+    struct CommandBuffer
+    {
+        // Entities to destroy at the next flush, in the order they were queued
+        std::vector<flecs::entity_t> destroys;
+
+        // Set for the entity indices in destroys, so queuing twice and checking are O(1)
+        std::vector<uint8_t> pending;
+
+        uint64_t created   = 0; // Entities made through createEntity
+        uint64_t destroyed = 0; // Entities removed by flushes
+        uint64_t flushes   = 0; // Flushes that had anything to destroy
+
+        double create_time = 0.0; // Microseconds spent making entities on the main thread
+        double flush_time  = 0.0; // Microseconds spent in flushes
+
+        CommandBuffer() = default;
+        CommandBuffer(CommandBuffer&&) = default;
+        CommandBuffer& operator=(CommandBuffer&&) = default;
+
+        void destroy(flecs::entity_t entity);
+        bool isDestroyed(flecs::entity_t entity) const;
+    };
+
+    /**
+     * @brief Get the command buffer of a world, it is made the first time it's needed
+     * @param world The world (not a stage)
+     * @return CommandBuffer& The buffer
+     */
+    CommandBuffer&
+    commandBuffer(flecs::world& world);
+
+    /**
+     * @brief Make an entity directly in the table of its components
+     *
+     * The components are default constructed, write them in place afterwards. Safe to call
+     * from the workers of the parallel script phase, where the stage defers it.
+     *
+     * @param world The world or the calling thread's stage
+     * @param ids   IDs of the components
+     * @return flecs::entity The entity
+     */
+    flecs::entity
+    createEntity(flecs::world& world, const std::vector<flecs::id_t>& ids);
+
+    /**
+     * @brief Destroy an entity at the next flush, safe to call from the workers
+     * @param world  The world (not a stage)
+     * @param entity The entity
+     */
+    void
+    queueDestroy(flecs::world_t* world, flecs::entity_t entity);
+
+    /**
+     * @brief Whether an entity is waiting to be destroyed, its scripts no longer run
+     * @param world  The world (not a stage)
+     * @param entity The entity
+     */
+    bool
+    isDestroyQueued(flecs::world& world, flecs::entity_t entity);
+
+    /**
+     * @brief Destroy the queued entities, emitting their Destroy events and giving their scripts
+     *        to the pool first
+     * @param world The world handle passed to Reset
+     * @return uint64_t The number of entities destroyed
+     */
+    uint64_t
+    flushCommands(const WorldHandle& world);
+}
@@ -6,9 +6,14 @@
 #include "../Util/Transform.hpp"
 
 #include "Mesh.hpp"
+#include "Shapes.hpp"
 
 #include <flecs.h>
 
+#include <array>
+#include <functional>
+#include <unordered_map>
+
 #define COMPONENT_DEFINITION(name, contents)                            \
     template<> struct Component<Name::name>                             \
     {                                                                   \
@@ -18,11 +23,43 @@
             contents                                                    \
         };                                                              \
         static Lua::Table getTable(const Data& data);                   \
-        static void fromTable(const Lua::Table& table, void* _data);    \
+        template<typename TableType>                                    \
+        static void fromTable(const TableType& table, void* _data);     \
+        static const Field& getLayout();                                \
     }   
 
 namespace S2D::Engine
 {
+    /**
+     * @brief Describes where a value lives inside a component so Lua can read and write it in place.
+     * 
+     * The names match the keys used by the component's getTable/fromTable.
+     */
+    struct Field
+    {
+        enum class Type
+        {
+            Number,   // Lua::Number
+            Unsigned, // uint32_t
+            Enum,     // int sized enum
+            Boolean,
+            String,
+            Struct    // Has its own fields
+        };
+
+        const char* name;
+        std::size_t offset;
+        Type type;
+        std::vector<Field> fields;
+
+        /**
+         * @brief Find a member of this struct by name
+         * @param name Name of the member
+         * @return const Field* The member or nullptr if it doesn't exist
+         */
+        const Field* find(const char* name) const;
+    };
+
     /**
      * @brief Assigns component world IDs to their respective name key in the table
      * @param table Table to set the names into
@@ -32,10 +69,128 @@ namespace S2D::Engine
 
     struct Script
     {
-        std::vector<std::pair<std::shared_ptr<Lua::Runtime>, int>> runtime;
+        /**
+         * @brief A script attached to an entity, releases its environment in the runtime when destroyed
+         */
+        struct Instance
+        {
+            std::shared_ptr<Lua::Runtime> runtime;
+            Lua::Runtime::Instance env = Lua::Runtime::Instance::Global;
+            bool started = false;
+
+            Instance(std::shared_ptr<Lua::Runtime> runtime, Lua::Runtime::Instance env);
+            Instance(Instance&& instance);
+            Instance& operator=(Instance&& instance);
+            ~Instance();
+        };
+
+        std::vector<Instance> runtime;
+
+        Script() = default;
+        Script(Script&&) = default;
+        Script& operator=(Script&&) = default;
+
         inline static std::string SourceDir;
+
+        // Whether entities running the same file share one runtime (each with its own
+        // environment) or each get a runtime of their own
+        inline static bool Shared = true;
+
+        // Run Start/Update on worker threads, one runtime per worker at a time. World changes
+        // made by the scripts go through per worker flecs stages and apply at the end of the phase
+        inline static bool Parallel = false;
+
+        // Number of workers, 0 for one per hardware thread
+        inline static uint32_t Threads = 0;
+
+        // Give each worker a fixed slice of the runtimes so the stages merge in the same order every frame
+        inline static bool Deterministic = true;
+
+        // Time spent in loadScript and how many scripts were loaded, reported with the frame times
+        inline static double   SpawnTime  = 0.0;
+        inline static uint32_t SpawnCount = 0;
+    };
+
+    /**
+     * @brief World singleton holding the runtimes shared between entities, keyed by filename
+     */
+    struct ScriptCache
+    {
+        std::unordered_map<std::string, std::shared_ptr<Lua::Runtime>> runtimes;
+    };
+
+    /**
+     * @brief A script whose System(world, iter) function runs once per matching table each frame
+     *        instead of once per entity, the components come from the script's global Query list
+     */
+    struct LuaSystem
+    {
+        Script::Instance script;
+        flecs::query<> query;
+        std::vector<flecs::id_t>  components;
+        std::vector<const Field*> layouts;
+    };
+
+    /**
+     * @brief World singleton keeping the scripts of destroyed entities for reuse, keyed by canonical path
+     * 
+     * Scripts are reset when they are put in the pool, so handing one to a new entity only
+     * sets self. A script can define Reset(world, entity) to clean up after itself instead,
+     * which skips running the script again.
+     */
+    struct ScriptPool
+    {
+        std::unordered_map<std::string, std::vector<Script::Instance>> free;
+
+        uint64_t hits     = 0; // Spawns served from the pool
+        uint64_t misses   = 0; // Spawns that had to create a script
+        uint64_t recycled = 0; // Scripts put back into the pool
+        uint64_t dropped  = 0; // Scripts released because the pool was full or the reset failed
+
+        ScriptPool() = default;
+        ScriptPool(ScriptPool&&) = default;
+        ScriptPool& operator=(ScriptPool&&) = default;
+
+        // Whether destroyed entities give their scripts back, and how many are kept per file
+        inline static bool     Enabled  = true;
+        inline static uint32_t Capacity = 256;
+    };
+
+    /**
+     * @brief World singleton holding the Lua systems in the order they were loaded
+     */
+    struct LuaSystems
+    {
+        std::vector<LuaSystem> systems;
+
+        LuaSystems() = default;
+        LuaSystems(LuaSystems&&) = default;
+        LuaSystems& operator=(LuaSystems&&) = default;
+    };
+
+    /**
+     * @brief The functions the engine calls on a script, each is cached in the runtime's
+     *        function slot of the same index when the script is loaded
+     */
+    enum class ScriptFunction
+    {
+        Start, Update, Collide, System, Reset, Events, Count
     };
 
+    static const char* operator*(ScriptFunction function)
+    {
+        switch (function)
+        {
+        case ScriptFunction::Start:   return "Start";
+        case ScriptFunction::Update:  return "Update";
+        case ScriptFunction::Collide: return "Collide";
+        case ScriptFunction::System:  return "System";
+        case ScriptFunction::Reset:   return "Reset";
+        case ScriptFunction::Events:  return "Events";
+        default: return "";
+        }
+    }
+
     // Assumes the _Enum has a ::Count member and that there is a *operator overload
     // That gives the name
     template<typename _Enum>
@@ -51,10 +206,52 @@ namespace S2D::Engine
     }
 
     std::unique_ptr<Lua::Runtime>
-    loadRuntime(const std::string& filename, flecs::world& world);
+    loadRuntime(const std::string& filename, flecs::world& world, bool instanced = false);
 
+    /**
+     * @brief Attach a script to an entity, sets "self" in the script's environment to the entity
+     * @param filename Path to the script
+     * @param world    World the entity lives in
+     * @param entity   The entity
+     * @param script   The entity's script component
+     */
     void 
-    loadScript(const std::string& filename, flecs::world& world, Script& script);
+    loadScript(const std::string& filename, flecs::world& world, flecs::entity entity, Script& script);
+
+    struct WorldHandle;
+
+    /**
+     * @brief Queue a script added from a worker thread, see \ref Script::Parallel
+     * @param world    The world (not a stage)
+     * @param entity   The entity
+     * @param filename Path to the script
+     */
+    void
+    deferScript(flecs::world_t* world, flecs::entity_t entity, const std::string& filename);
+
+    /**
+     * @brief Load the scripts queued with \ref deferScript for a world
+     * @param world The world, after the stages have been merged
+     */
+    void
+    loadDeferredScripts(flecs::world& world);
+
+    /**
+     * @brief Give the scripts of an entity that is about to be destroyed to the world's \ref ScriptPool
+     * @param world  The world handle passed to Reset
+     * @param entity The entity
+     * @param script The entity's script component, left empty
+     */
+    void
+    recycleScript(const WorldHandle& world, flecs::entity entity, Script& script);
+
+    /**
+     * @brief Load a system script into the world's \ref LuaSystems
+     * @param filename Path to the script
+     * @param world    The world
+     */
+    void
+    loadSystem(const std::string& filename, flecs::world& world);
 
     enum class Name
     {
@@ -70,8 +267,6 @@ namespace S2D::Engine
         Count
     };
 
-    struct Dead { };
-
     static const char* operator*(Name name)
     {
         switch (name)
@@ -96,6 +291,74 @@ namespace S2D::Engine
         flecs::id_t component_id, 
         flecs::world& world);
 
+    /**
+     * @brief Get the field layout of a component from its world ID
+     * @param component_id ID of the component in the world
+     * @param world        The world
+     * @return const Field* The layout or nullptr if it isn't an engine component
+     */
+    const Field*
+    getComponentLayout(
+        flecs::id_t component_id,
+        flecs::world& world);
+
+    /**
+     * @brief The operations the Lua bindings need on a component whose type is only known at runtime
+     */
+    struct ComponentInfo
+    {
+        const char*  name;
+        std::size_t  size;
+        const Field* layout;
+
+        // Engine components use plain functions, components declared at runtime capture their layout
+        std::function<Lua::Table(const void* data)> getTable;
+        std::function<void(Lua::State L, const void* data)> push; // Same as getTable(data).toStack(L)
+        std::function<void(const Lua::Table& table, void* data)> fromTable;
+        std::function<void(const Lua::TableView& table, void* data)> fromView;
+
+        // Adds the component to the entity, read from the table if there is one
+        std::function<void(flecs::entity entity, const Lua::TableView* table)> emplace;
+    };
+
+    /**
+     * @brief World singleton mapping component IDs to their \ref ComponentInfo
+     *
+     * It is filled with the engine components when the scene starts, so a binding finds its
+     * component with one lookup instead of asking the world for the ID of every engine component.
+     * Components made at runtime are added with add().
+     */
+    struct ComponentTable
+    {
+        std::vector<ComponentInfo> infos;
+
+        std::vector<int32_t> dense; // Index into infos by component ID, -1 if there is none
+        std::unordered_map<flecs::id_t, uint32_t> sparse; // IDs past DenseLimit
+
+        static constexpr flecs::id_t DenseLimit = 1 << 16;
+
+        void add(flecs::id_t id, const ComponentInfo& info);
+
+        const ComponentInfo* find(flecs::id_t id) const;
+    };
+
+    /**
+     * @brief Get the component table of a world, it is built the first time it's needed
+     * @param world The world (not a stage)
+     * @return const ComponentTable& The table
+     */
+    const ComponentTable&
+    componentTable(flecs::world_t* world);
+
+    /**
+     * @brief Add a component made at runtime to the world's component table
+     * @param world The world (not a stage)
+     * @param id    ID of the component in the world
+     * @param info  How the bindings read and write it
+     */
+    void
+    registerComponent(flecs::world_t* world, flecs::id_t id, const ComponentInfo& info);
+
     template<Name T>
     struct Component;
 
@@ -144,16 +407,39 @@ namespace S2D::Engine
             Solid, NotSolid
         };
 
+        /**
+         * @brief A byte per tile counting the solid layers that have a tile there
+         *
+         * Stored in square chunks made the first time a solid tile lands in them, so tiles far
+         * apart don't cost the space between them. Collisions look tiles up here instead of
+         * going through a collision mesh.
+         */
+        struct SolidGrid
+        {
+            static constexpr int32_t ChunkShift = 5;
+            static constexpr int32_t ChunkSize  = 1 << ChunkShift;
+
+            std::unordered_map<uint32_t, std::array<uint8_t, ChunkSize * ChunkSize>> chunks;
+
+            bool solid(int32_t tile_x, int32_t tile_y) const;
+            void add(int32_t tile_x, int32_t tile_y, int32_t count);
+        };
+
         struct Map
         {
             std::unordered_map<
                 uint32_t, // Layer number
                 std::pair<std::unordered_map<int32_t, Tile>, LayerState> // Layer
             > map;
+            SolidGrid solid;
             bool changed;
 
             void setTile(int16_t x, int16_t y, uint32_t layer, const Tile& tile);
             void setLayerState(uint32_t layer, LayerState state);
+
+            // Tile coordinates to and from the keys of a layer
+            static int32_t key(int16_t x, int16_t y);
+            static void coords(int32_t key, int16_t& x, int16_t& y);
         };
 
         static constexpr Name Type = Name::Tilemap;
@@ -172,14 +458,53 @@ namespace S2D::Engine
         static int setLayerState(Lua::State L);
 
         static Lua::Table getTable(const Data& data);
-        static void fromTable(const Lua::Table& table, void* _data);
+        template<typename TableType>
+        static void fromTable(const TableType& table, void* _data);
+        static const Field& getLayout();
     };
 
     COMPONENT_DEFINITION(Collider,
         Lua::Number collider_component;
         std::unique_ptr<CollisionMesh> mesh;    
+        bool is_static = false; // Placed once, never follows its Transform
+        ColliderShape shape = ColliderShape::Mesh;
+        Math::Vec2f size;                  // Box (the sprite's size when left at zero), the width is a capsule's segment
+        Lua::Number radius = 0.f;          // Circle and capsule
+        std::vector<Math::Vec2f> points;   // Polygon, convex
     );
 
+    /**
+     * @brief The collision object of an entity's collider, kept with the entity between frames
+     * 
+     * It is its own component since the Collider can be shared through a prefab. The object
+     * leaves the scene's broadphase when the entity is destroyed.
+     */
+    struct CollisionProxy
+    {
+        std::shared_ptr<void> object; // fcl data, see Collide.cpp
+    };
+
+    /**
+     * @brief Where an entity's Transform was at the start of the last tick
+     * 
+     * Frames are drawn between this and the Transform, see \ref Time. Entities get it
+     * the first tick they have a Transform.
+     */
+    struct PreviousTransform
+    {
+        Math::Vec3f position;
+        float scale;
+        float rotation;
+    };
+
+    /**
+     * @brief Where to draw an entity, Time::interpolation of the way from its PreviousTransform
+     *        to its Transform. Nothing is written, the simulation keeps the Transform as it is.
+     * @param entity The entity, it has to have a Transform
+     * @return Transform The blended Transform
+     */
+    Component<Name::Transform>::Data interpolatedTransform(flecs::entity entity);
+
     enum class Projection
     {
         Orthographic, Perspective, Count
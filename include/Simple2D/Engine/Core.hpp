@@ -13,6 +13,7 @@
 namespace S2D::Engine
 {
     struct Application;
+    struct ThreadPool;
 
     struct Scene : Util::NoCopy
     {
@@ -28,9 +29,12 @@ namespace S2D::Engine
         // Important cached queries for rendering
         flecs::query<Script> scripts; // for script system
         flecs::query<Transform, Rigidbody> rigidbodies; // for collision
-        flecs::query<const Collider, Transform, Rigidbody> colliders; // for collision
+        flecs::query<const Transform> untracked; // Transforms without a PreviousTransform yet
+        flecs::query<const Transform, PreviousTransform> tracked; // for interpolation
         //flecs::query<const Transform> transforms; // for rendering
-        flecs::query<Dead> dead; // for cleanup
+
+        // The collision objects kept between frames, only Collide.cpp knows what's in it (fcl stays out of the headers)
+        std::shared_ptr<void> broadphase;
 
         std::unique_ptr<Renderer> renderer;
         std::unique_ptr<Renderpass> renderpass;
@@ -57,16 +61,51 @@ namespace S2D::Engine
 
         void run();
 
+        /**
+         * @brief Run one tick of collision on a scene: keep its broadphase up to date and push
+         *        the rigidbodies out of what they hit, queuing a Collision event for each
+         * @param scene The scene
+         */
+        static void collide(Scene* scene);
+
+        /**
+         * @brief Run Start (the first time) and Update of every script in a scene on this thread
+         * @param scene The scene
+         * @return uint64_t Number of entities whose scripts ran
+         */
+        static uint64_t updateScripts(Scene* scene);
+
+        /**
+         * @brief Run Start/Update of every script in a scene on a pool of workers, each writing
+         *        into its own stage of the world until they are all done
+         * @param scene   The scene
+         * @param workers The workers, the world gets a stage for each
+         * @return uint64_t Number of entities whose scripts ran
+         */
+        static uint64_t updateParallel(Scene* scene, ThreadPool& workers);
+
+        /**
+         * @brief Call every Lua system of a scene once per table matching its query
+         * @param scene The scene
+         * @return uint64_t Number of calls made
+         */
+        static uint64_t runSystems(Scene* scene);
+
         Core(const Application& app);
         ~Core();
 
     private:
         void render(Scene* scene);
-        void collide(Scene* scene);
+#   ifdef LUA_HOT_RELOAD
+        void reload(Scene* scene);
+#   endif
 
         Graphics::DrawWindow window;
 
         std::stack<Scene*> _scenes;
+
+        // Workers for the parallel script phase, made the first time it runs
+        std::unique_ptr<ThreadPool> _workers;
     };
 
     template<typename T, typename... Args>
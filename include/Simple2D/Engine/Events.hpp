@@ -0,0 +1,127 @@
+#pragma once
+
+#include "../Util/Vector.hpp"
+
+#include <flecs.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace S2D::Engine
+{
+    struct WorldHandle;
+
+    /**
+     * @brief The events the engine emits itself, their IDs are interned first in every bus
+     */
+    enum class EventType
+    {
+        Collision, Destroy, Count
+    };
+
+    static const char* operator*(EventType type)
+    {
+        switch (type)
+        {
+        case EventType::Collision: return "Collision";
+        case EventType::Destroy:   return "Destroy";
+        default: return "";
+        }
+    }
+
+    /**
+     * @brief A single event, the same plain struct is used for every type so the queues stay contiguous
+     *
+     * Collision: source collided with target, vector is the resolution and value its depth.
+     * Destroy:   source was destroyed.
+     * Custom:    source emitted it, target is the receiver (0 for everyone) and value the payload.
+     */
+    struct Event
+    {
+        uint32_t type;
+        flecs::entity_t source = 0;
+        flecs::entity_t target = 0;
+        S2D::Math::Vec2f vector;
+        float value = 0.f;
+    };
+
+    /**
+     * @brief World singleton queuing the events of a frame until they are dispatched
+     *
+     * Events are queued by name, one queue per name. Once per frame, every subscribed entity
+     * gets all of its events in one call to Events(world, entity, events) on its scripts.
+     * Events emitted while dispatching are delivered the next frame.
+     */
+    struct EventBus
+    {
+        // Queues being filled, indexed by the interned name
+        std::vector<std::vector<Event>> queues;
+
+        // Queues being dispatched, swapped with the ones above so they keep their capacity
+        std::vector<std::vector<Event>> dispatching;
+
+        std::vector<std::string> names;
+        std::unordered_map<std::string, uint32_t> ids;
+
+        // Entity and the name it listens to, kept sorted by entity while dispatching
+        std::vector<std::pair<flecs::entity_t, uint32_t>> subscriptions;
+
+        // Scratch list of the events of one subscriber
+        std::vector<const Event*> batch;
+
+        uint64_t dispatched = 0; // Events handed to scripts
+        uint64_t batches    = 0; // Calls made to deliver them
+
+        EventBus();
+        EventBus(EventBus&&) = default;
+        EventBus& operator=(EventBus&&) = default;
+
+        /**
+         * @brief Get the ID of an event name, making one if it doesn't have one yet
+         * @param name Name of the event
+         * @return uint32_t The ID
+         */
+        uint32_t intern(const std::string& name);
+
+        void push(const Event& event);
+
+        void subscribe(flecs::entity_t entity, uint32_t type);
+        void unsubscribe(flecs::entity_t entity, uint32_t type);
+    };
+
+    /**
+     * @brief Get the event bus of a world, it is made the first time it's needed
+     * @param world The world (not a stage)
+     * @return EventBus& The bus
+     */
+    EventBus&
+    eventBus(flecs::world& world);
+
+    /**
+     * @brief Queue an event by name, safe to call from the workers of the parallel script phase
+     * @param world The world (not a stage)
+     * @param name  Name of the event
+     * @param event The event, its type is set from the name
+     */
+    void
+    emitEvent(flecs::world_t* world, const std::string& name, Event event);
+
+    /**
+     * @brief Start or stop delivering events of a name to an entity, safe to call from the workers
+     * @param world     The world (not a stage)
+     * @param entity    The entity
+     * @param name      Name of the event
+     * @param subscribe Whether to subscribe or unsubscribe
+     */
+    void
+    subscribeEvent(flecs::world_t* world, flecs::entity_t entity, const std::string& name, bool subscribe);
+
+    /**
+     * @brief Deliver the events queued this frame, see \ref EventBus
+     * @param world The world handle passed to the scripts
+     * @return uint64_t The number of events delivered
+     */
+    uint64_t
+    dispatchEvents(const WorldHandle& world);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "../Util.hpp"
+#include "../Lua.hpp"
+
+#ifdef LUA_HOT_RELOAD
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace S2D::Engine
+{
+    /**
+     * @brief Watches script and shader files on a background thread
+     * 
+     * Changed scripts are recompiled off the main thread, the core picks the results up
+     * at the start of a frame with \ref poll and swaps them into the runtimes running that file.
+     */
+    struct HotReload : Util::NoCopy
+    {
+        struct Change
+        {
+            std::filesystem::path path;
+
+            // Compiled chunk for scripts, empty for anything else
+            std::string chunk;
+
+            // Set if the script failed to compile
+            std::string error;
+        };
+
+        static HotReload& instance();
+
+        /**
+         * @brief Start watching a file, starts the watcher thread on the first call
+         * @param filename The file to watch
+         */
+        void watch(const std::filesystem::path& filename);
+
+        /**
+         * @brief Take the changes found since the last call
+         * @return std::vector<Change> One entry per changed file
+         */
+        std::vector<Change> poll();
+
+        ~HotReload();
+
+    private:
+        HotReload();
+
+        void _run();
+        void _changed(const std::filesystem::path& filename);
+
+        std::mutex _mutex;
+        std::thread _thread;
+        std::atomic<bool> _running;
+
+        // Canonical path -> last write time, guarded by _mutex
+        std::unordered_map<std::string, std::filesystem::file_time_type> _files;
+
+        // Changes waiting for the next poll, keyed by path so repeated saves collapse, guarded by _mutex
+        std::unordered_map<std::string, Change> _changes;
+
+#       ifdef __linux__
+        // inotify watch descriptor -> watched directory
+        std::unordered_map<int, std::filesystem::path> _directories;
+        int _fd;
+#       endif
+    };
+}
+
+#endif
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "../../Lua.hpp"
+#include "../Components.hpp"
+
+#include <flecs.h>
+
+namespace S2D::Engine
+{
+    /**
+     * @brief The userdata returned by Entity.getComponentRef, it points at a component (or a struct
+     *        inside of one) in the world's storage instead of holding a copy.
+     */
+    struct ComponentHandle
+    {
+        static constexpr const char* TypeName = "ComponentRef";
+
+        flecs::world_t* world;
+        flecs::entity_t entity;
+        flecs::id_t     component;
+
+        // The struct being viewed and where it sits inside the component
+        const Field* field;
+        std::size_t  offset;
+
+        // Set for rows of a system's column, the component is read from here instead of the entity
+        // and is only valid while the system runs, epoch is the System::epoch of that call
+        char* data;
+        uint32_t epoch;
+    };
+
+    /**
+     * @brief Metamethods that read and write component fields in place.
+     * 
+     * Writes mark the component as modified so change detection still sees them.
+     */
+    struct ComponentRef : Lua::Lib::Base
+    {
+        static int index(Lua::State L);
+        static int newIndex(Lua::State L);
+
+        ComponentRef();
+    };
+}
@@ -32,6 +32,17 @@ namespace LuaAPI
 
 #endif
 
+    /**
+     * @brief The userdata scripts receive for an entity, one per entity per runtime.
+     */
+    struct EntityHandle
+    {
+        static constexpr const char* TypeName = "Entity";
+
+        flecs::world_t* world;
+        flecs::entity_t entity;
+    };
+
     /**
      * @brief Represents the methods associated with manipulating an entity in Lua.
      */
@@ -42,11 +53,41 @@ namespace LuaAPI
         static std::pair<flecs::world, flecs::entity>
         extractWorldInfo(const Lua::Table& entity_or_component);
 
+        static std::pair<flecs::world, flecs::entity>
+        extractWorldInfo(const Lua::TableView& entity_or_component);
+
+        static std::pair<flecs::world, flecs::entity>
+        extractWorldInfo(const EntityHandle& entity);
+
         static int getComponent(Lua::State L);
         static int setComponent(Lua::State L);
+
+        // Returns a ComponentRef pointing into the world instead of a copy, nil from a parallel script
+        static int getComponentRef(Lua::State L);
+
+        // Returns the address of the component in the world as light userdata, for FFI casts.
+        // Gives nil from a parallel script. The component counts as changed when the pointer is
+        // handed out, so the pointer is only good for the tick it was fetched in.
+        static int getComponentPtr(Lua::State L);
         static int destroy(Lua::State L);
         static int addScript(Lua::State L);
 
         Entity();
     };
-}
\ No newline at end of file
+}
+
+namespace S2D::Lua::CompileTime
+{
+    template<>
+    struct TypeMap<Engine::EntityHandle>
+    {
+        static bool
+        check(State L);
+
+        static void
+        push(State L, const Engine::EntityHandle& val);
+
+        static Engine::EntityHandle
+        construct(State L);
+    };
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "../../Lua.hpp"
+#include "../Events.hpp"
+
+#include <flecs.h>
+
+namespace S2D::Engine
+{
+    /**
+     * @brief The batch a script's Events(world, entity, events) function receives, one per frame.
+     *
+     * It points into the bus's queues so it is only valid during the call, using it after the
+     * call returns raises an error.
+     */
+    struct EventBatchHandle
+    {
+        static constexpr const char* TypeName = "EventBatch";
+
+        flecs::world_t* world;
+        const EventBus* bus;
+
+        const Event* const* events;
+        int32_t count;
+        uint32_t epoch; // EventBatch::epoch during the call it was made for
+    };
+
+    /**
+     * @brief Methods an entity gets for the event bus: subscribe(name), unsubscribe(name)
+     *        and emit(name [, value [, target]])
+     */
+    struct Events : Lua::Lib::Base
+    {
+        static int subscribe(Lua::State L);
+        static int unsubscribe(Lua::State L);
+        static int emit(Lua::State L);
+
+        Events();
+    };
+
+    /**
+     * @brief Methods of an event batch: count() and get(i), which returns the name, source,
+     *        target (or nil), x, y and value of the event without making a table
+     */
+    struct EventBatch : Lua::Lib::Base
+    {
+        static int count(Lua::State L);
+        static int get(Lua::State L);
+
+        // Bumped after every Events(world, entity, events) call, batches made for an older one are stale
+        inline static uint32_t epoch = 0;
+
+        EventBatch();
+    };
+}
+
+namespace S2D::Lua::CompileTime
+{
+    template<>
+    struct TypeMap<Engine::EventBatchHandle>
+    {
+        static bool
+        check(State L);
+
+        static void
+        push(State L, const Engine::EventBatchHandle& val);
+
+        static Engine::EventBatchHandle
+        construct(State L);
+    };
+}
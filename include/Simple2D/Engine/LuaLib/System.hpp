@@ -0,0 +1,96 @@
+#pragma once
+
+#include "../../Lua.hpp"
+#include "../Components.hpp"
+
+#include <flecs.h>
+
+namespace S2D::Engine
+{
+    /**
+     * @brief The iterator a system's System(world, iter) function receives, one per matching table.
+     * 
+     * It points into the table's storage so it is only valid during the call, using it (or a
+     * column or row taken from it) after the call returns raises an error.
+     */
+    struct SystemIterHandle
+    {
+        static constexpr const char* TypeName = "SystemIter";
+
+        flecs::world_t* world;
+        const LuaSystem* system;
+
+        const flecs::entity_t* entities;
+        void* const*   columns;
+        const int32_t* sizes;
+        int32_t count;
+        uint64_t shared; // Bit per term that isn't the rows' own storage, never handed to scripts
+        uint32_t epoch;  // System::epoch during the call it was made for
+    };
+
+    /**
+     * @brief A view over one component of every row in the iterator, indexing it gives a ComponentRef
+     */
+    struct ColumnHandle
+    {
+        static constexpr const char* TypeName = "Column";
+
+        flecs::world_t* world;
+        const flecs::entity_t* entities;
+        flecs::id_t  component;
+        const Field* layout;
+
+        char* data;
+        std::size_t stride;
+        int32_t count;
+        uint32_t epoch;
+    };
+
+    /**
+     * @brief Methods of the system iterator: count(), entity(i), field(k) and fieldPtr(k)
+     *
+     * Systems only match components the entities own, field(k) and fieldPtr(k) give nil
+     * for a term that isn't stored per row.
+     */
+    struct System : Lua::Lib::Base
+    {
+        static int count(Lua::State L);
+        static int entity(Lua::State L);
+        static int field(Lua::State L);
+
+        // Returns the address of the column as light userdata and the component ID, for FFI casts
+        static int fieldPtr(Lua::State L);
+
+        // Bumped after every System(world, iter) call, handles made for an older one are stale
+        inline static uint32_t epoch = 0;
+
+        System();
+    };
+
+    /**
+     * @brief Metamethods of a column: column[i] and #column
+     */
+    struct Column : Lua::Lib::Base
+    {
+        static int index(Lua::State L);
+        static int length(Lua::State L);
+
+        Column();
+    };
+}
+
+namespace S2D::Lua::CompileTime
+{
+    template<>
+    struct TypeMap<Engine::SystemIterHandle>
+    {
+        static bool
+        check(State L);
+
+        static void
+        push(State L, const Engine::SystemIterHandle& val);
+
+        static Engine::SystemIterHandle
+        construct(State L);
+    };
+}
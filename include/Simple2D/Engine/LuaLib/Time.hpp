@@ -4,10 +4,27 @@
 
 namespace S2D::Engine
 {
+    /**
+     * @brief Timing of the fixed-step simulation and the frames drawn around it
+     *
+     * Scripts, collisions and rigidbodies run in ticks of 1 / tick_rate seconds, as many per
+     * frame as the time since the last frame covers (up to max_substeps, the rest is dropped).
+     * Frames draw each Transform interpolation of the way from the previous tick to the last.
+     */
     struct Time : Lua::Lib::Base
     {
-        inline static double dt;
+        inline static double dt;                // Length of a tick
+        inline static double frame_dt;          // Length of the last frame
+        inline static double tick_rate = 60.0;  // Ticks per second
+        inline static uint32_t max_substeps = 8;
+        inline static double interpolation;     // How far the frame is between the last two ticks, [0, 1)
+
         static int deltaTime(Lua::State L);
+        static int frameTime(Lua::State L);
+        static int tickRate(Lua::State L);
+        static int renderRate(Lua::State L);
+        static int setTickRate(Lua::State L);
+        static int alpha(Lua::State L);
         Time();
     };
-}
\ No newline at end of file
+}
@@ -2,13 +2,68 @@
 
 #include "../../Lua.hpp"
 
+#include <flecs.h>
+
 namespace S2D::Engine
 {
+    /**
+     * @brief The userdata scripts receive for the world, one per runtime.
+     */
+    struct WorldHandle
+    {
+        static constexpr const char* TypeName = "World";
+
+        flecs::world_t* world;
+        void* scene;
+    };
+
+    /**
+     * @brief The flecs stage the calling thread writes through
+     * 
+     * While scripts update in parallel each worker writes into its own stage, which is merged
+     * into the world at the end of the phase. Handles always hold the world itself and the
+     * libraries resolve it through this whenever they touch the ECS.
+     * 
+     * @param world The world from a handle
+     * @return flecs::world_t* The worker's stage, or the world outside the parallel phase
+     */
+    flecs::world_t* stage(flecs::world_t* world);
+
+    /**
+     * @brief Set the stage of the calling thread, nullptr to go back to the world
+     */
+    void setStage(flecs::world_t* stage);
+
     struct World : Lua::Lib::Base
     {
         static int createEntity(Lua::State L);
         static int getEntity(Lua::State L);
+
+        // world:defineComponent(name, { field = "number" | "bool" | "vec2" | "vec3" }) -> id or nil
+        static int defineComponent(Lua::State L);
+
+        // world:definePrefab({ name = ..., components = {...}, owned = {...}, scripts = {...} }) -> bool
+        static int definePrefab(Lua::State L);
+
+        // world:spawn(prefab [, count [, overrides]]) -> { entities }, overrides are { type = ..., value = ... } tables
+        static int spawn(Lua::State L);
         
         World();
     };
-}
\ No newline at end of file
+}
+
+namespace S2D::Lua::CompileTime
+{
+    template<>
+    struct TypeMap<Engine::WorldHandle>
+    {
+        static bool
+        check(State L);
+
+        static void
+        push(State L, const Engine::WorldHandle& val);
+
+        static Engine::WorldHandle
+        construct(State L);
+    };
+}
@@ -17,8 +17,11 @@ namespace S2D::Engine
         virtual void poststart() {}
 
     private:
+        void load_components(const Lua::Table& components);
         void load_entities(const Lua::Table& entities);
+        void load_prefabs(const Lua::Table& prefabs);
         void load_resources(const Lua::Table& resources);
+        void load_systems(const Lua::Table& systems);
 
         Lua::Runtime runtime;
     };
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "../Lua.hpp"
+
+#include <flecs.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace S2D::Engine
+{
+    /**
+     * @brief A flecs prefab entities are spawned from with an IsA pair
+     *
+     * The components of the prefab are shared by every instance, only the owned ones are
+     * copied into each instance when it is spawned. Transform and Rigidbody are always owned,
+     * the engine moves every entity on its own. Writing to a shared component through
+     * setComponent gives that entity its own copy.
+     */
+    struct Prefab
+    {
+        flecs::entity_t entity;
+
+        // Components copied into every instance
+        std::vector<flecs::id_t> owned;
+
+        // Scripts loaded on every instance, scripts are never shared
+        std::vector<std::string> scripts;
+    };
+
+    /**
+     * @brief World singleton holding the prefabs by name
+     */
+    struct Prefabs
+    {
+        std::unordered_map<std::string, Prefab> prefabs;
+
+        uint64_t spawned    = 0;   // Instances made through spawnMany
+        double   spawn_time = 0.0; // Microseconds spent in spawnMany
+
+        Prefabs() = default;
+        Prefabs(Prefabs&&) = default;
+        Prefabs& operator=(Prefabs&&) = default;
+    };
+
+    /**
+     * @brief Declare a prefab from the same table the scene's GetEntities entries use
+     *
+     * { name = "...", components = { { type = ..., value = {...} } }, owned = { ... }, scripts = { ... } }
+     * where owned lists the component IDs every instance gets its own copy of.
+     * Declaring a name again gives back the prefab it already has.
+     *
+     * @param world      The world (not a stage)
+     * @param definition The definition
+     * @return const Prefab* The prefab, nullptr if the definition has no name
+     */
+    const Prefab*
+    definePrefab(flecs::world& world, const Lua::Table& definition);
+
+    /**
+     * @brief Find a prefab declared with \ref definePrefab
+     * @param world The world (not a stage)
+     * @param name  Name of the prefab
+     * @return const Prefab* The prefab or nullptr if there isn't one with that name
+     */
+    const Prefab*
+    findPrefab(flecs::world& world, const std::string& name);
+
+    /**
+     * @brief Spawn instances of a prefab, all of them are made together in their final table
+     *
+     * From the workers of the parallel script phase, where flecs can't make them in bulk, the
+     * instances are made one by one through the stage and their scripts load after the merge.
+     *
+     * @param world    The world or the calling thread's stage
+     * @param prefab   The prefab
+     * @param count    Number of instances
+     * @param owned    IDs of extra components every instance owns, written by the caller afterwards
+     * @return std::vector<flecs::entity_t> The instances
+     */
+    std::vector<flecs::entity_t>
+    spawnMany(flecs::world& world, const Prefab& prefab, uint32_t count, const std::vector<flecs::id_t>& owned = {});
+}
@@ -3,6 +3,7 @@
 #include "../Util.hpp"
 
 #include "../Graphics.hpp"
+#include <filesystem>
 #include <unordered_map>
 
 namespace S2D::Engine
@@ -42,9 +43,20 @@ namespace S2D::Engine
         Result<T*>
         getResource(const std::string& name);
 
+        /**
+         * @brief Recompiles every program that uses a shader file
+         * @param filename Canonical path of the shader file
+         * @return uint32_t The number of programs reloaded
+         */
+        uint32_t
+        reloadShaders(const std::filesystem::path& filename);
+
     private:
         using ResourceMap = std::unordered_map<std::string, std::shared_ptr<void>>;
         std::unordered_map<std::size_t, ResourceMap> resources;
+
+        // The files each program was built from, so they can be rebuilt when one changes
+        std::unordered_map<std::string, std::unordered_map<Graphics::Shader::Type, std::string>> shader_sources;
     };
 
 }
\ No newline at end of file
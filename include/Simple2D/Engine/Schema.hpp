@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Components.hpp"
+
+#include <deque>
+
+namespace S2D::Engine
+{
+    /**
+     * @brief A component declared at runtime from a schema
+     *
+     * The fields are packed into a plain struct (numbers first, then booleans) and registered
+     * with flecs like any other component, so they live in the world's columns. C++ can query
+     * them by \ref id and read the fields through \ref layout.
+     */
+    struct ComponentSchema
+    {
+        std::string name;
+        flecs::id_t id;
+        std::size_t size;
+
+        Field layout;
+
+        // The layout's field names point in here
+        std::deque<std::string> names;
+    };
+
+    /**
+     * @brief World singleton owning the schemas declared in it
+     */
+    struct ComponentSchemas
+    {
+        // Boxed so the layouts handed to the component table never move
+        std::vector<std::unique_ptr<ComponentSchema>> schemas;
+
+        ComponentSchemas() = default;
+        ComponentSchemas(ComponentSchemas&&) = default;
+        ComponentSchemas& operator=(ComponentSchemas&&) = default;
+    };
+
+    /**
+     * @brief Declare a component from a schema mapping field names to their type
+     *
+     * The types are "number", "bool", "vec2" and "vec3" (with x, y and z numbers). Declaring
+     * a name again gives back the component it already has.
+     *
+     * @param world  The world (not a stage)
+     * @param name   Name of the component
+     * @param schema The schema
+     * @return flecs::id_t The ID of the component or 0 if the schema is invalid
+     */
+    flecs::id_t
+    defineComponent(flecs::world& world, const std::string& name, const Lua::Table& schema);
+
+    /**
+     * @brief Find a component declared with \ref defineComponent
+     * @param world The world
+     * @param name  Name of the component
+     * @return const ComponentSchema* The schema or nullptr if there isn't one with that name
+     */
+    const ComponentSchema*
+    findSchema(flecs::world& world, const std::string& name);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "../Util/Vector.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace S2D::Engine
+{
+    /**
+     * @brief What a collider collides as. Mesh goes through the fcl model of the entity's
+     *        sprite or tilemap, the others are tested natively in 2D.
+     */
+    enum class ColliderShape
+    {
+        Mesh, Box, Circle, Capsule, Polygon, Count
+    };
+
+    static const char* operator*(ColliderShape shape)
+    {
+        switch (shape)
+        {
+        case ColliderShape::Mesh:    return "Mesh";
+        case ColliderShape::Box:     return "Box";
+        case ColliderShape::Circle:  return "Circle";
+        case ColliderShape::Capsule: return "Capsule";
+        case ColliderShape::Polygon: return "Polygon";
+        default: return "";
+        }
+    }
+
+    /**
+     * @brief A convex shape in world space, rounded by a radius
+     *
+     * Every native shape is one of these: a box or polygon is its corners with no radius,
+     * a circle is one point and a capsule the two ends of its segment.
+     */
+    struct Shape2D
+    {
+        std::vector<S2D::Math::Vec2f> points; // Counter-clockwise
+        float radius = 0.f;
+
+        // Bounds, the radius included
+        S2D::Math::Vec2f min, max;
+    };
+
+    /**
+     * @brief Where two shapes overlap: b has to move depth along normal to separate from a
+     */
+    struct Manifold
+    {
+        S2D::Math::Vec2f normal;
+        float depth = 0.f;
+
+        S2D::Math::Vec2f points[2];
+        uint32_t count = 0;
+    };
+
+    /**
+     * @brief Place a collider's shape in the world
+     * @param shape    The shape, Mesh gives an empty one
+     * @param size     Width and height of a box, the width is the segment of a capsule
+     * @param radius   Radius of a circle or capsule
+     * @param points   Corners of a polygon around its origin
+     * @param position Where the origin is
+     * @param rotation Rotation around the origin in degrees
+     * @param scale    Scale of everything above
+     * @return Shape2D The shape
+     */
+    Shape2D
+    makeShape(
+        ColliderShape shape,
+        S2D::Math::Vec2f size,
+        float radius,
+        const std::vector<S2D::Math::Vec2f>& points,
+        S2D::Math::Vec2f position,
+        float rotation,
+        float scale);
+
+    /**
+     * @brief Test two shapes with the separating axis theorem
+     * @param a        The first shape
+     * @param b        The second shape
+     * @param manifold Filled in when they overlap
+     * @return bool Whether they overlap
+     */
+    bool
+    collideShapes(const Shape2D& a, const Shape2D& b, Manifold& manifold);
+}
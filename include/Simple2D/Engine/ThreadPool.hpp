@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../Util.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace S2D::Engine
+{
+    /**
+     * @brief A fixed set of worker threads that all run the same job and are waited on together
+     */
+    struct ThreadPool : Util::NoCopy
+    {
+        /**
+         * @brief Start the workers
+         * @param count Number of workers including the calling thread, which is worker 0
+         */
+        ThreadPool(uint32_t count);
+        ~ThreadPool();
+
+        uint32_t size() const { return _threads.size() + 1; }
+
+        /**
+         * @brief Run a job once on every worker and wait until they are all done
+         * @param job Function taking the index of the worker running it
+         */
+        void run(const std::function<void(uint32_t)>& job);
+
+    private:
+        void _work(uint32_t index);
+
+        std::vector<std::thread> _threads;
+
+        std::mutex _mutex;
+        std::condition_variable _start;
+        std::condition_variable _done;
+
+        const std::function<void(uint32_t)>* _job = nullptr;
+        uint64_t _generation = 0;
+        uint32_t _remaining  = 0;
+        bool     _quit       = false;
+    };
+}
@@ -42,6 +42,17 @@ namespace S2D::Graphics
         Util::Result<void> link();
         void use() const;
 
+        /**
+         * @brief Recompiles and relinks the program from new sources
+         * 
+         * The new program is built on the side, so if a shader fails to compile or link
+         * the current one keeps running.
+         * 
+         * @param sources Source code for each shader stage
+         * @return Util::Result<void> The compile or link error
+         */
+        Util::Result<void> reload(const std::unordered_map<Shader::Type, std::string>& sources);
+
         bool ready() const;
 
         [[nodiscard]]
@@ -1,5 +1,10 @@
 #pragma once
 
+#include "Lua/Allocator.hpp"
+#include "Lua/ChunkCache.hpp"
 #include "Lua/Lib.hpp"
+#include "Lua/Profiler.hpp"
 #include "Lua/Runtime.hpp"
-#include "Lua/Table.hpp"
\ No newline at end of file
+#include "Lua/Table.hpp"
+#include "Lua/TableView.hpp"
+#include "Lua/Userdata.hpp"
\ No newline at end of file
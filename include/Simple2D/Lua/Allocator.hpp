@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Lib.hpp"
+
+#include "../Util.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace S2D::Lua
+{
+    /**
+     * @brief Allocator handed to a Lua state, one per \ref Runtime
+     * 
+     * Small blocks (most tables, strings and closures) come from per size class free lists
+     * carved out of larger arenas, so they never reach malloc after warming up. Anything
+     * bigger than the largest class goes straight to malloc. The runtime is only ever used
+     * from one thread at a time, so nothing here is locked.
+     */
+    struct Allocator : Util::NoCopy
+    {
+        struct Stats
+        {
+            std::size_t live        = 0; // Bytes handed out to Lua right now
+            std::size_t peak        = 0; // Highest value live has reached
+            std::size_t reserved    = 0; // Bytes held in arenas, including the free lists
+            uint64_t    allocations = 0; // Number of blocks allocated over the lifetime
+            uint64_t    frees       = 0; // Number of blocks freed over the lifetime
+        };
+
+        Allocator() = default;
+        ~Allocator() = default;
+
+        /**
+         * @brief The lua_Alloc function, ud is the Allocator
+         */
+        static void* alloc(void* ud, void* ptr, std::size_t osize, std::size_t nsize);
+
+        const Stats& stats() const { return _stats; }
+
+    private:
+        static constexpr std::size_t Granularity = 16;
+        static constexpr std::size_t MaxSize     = 512;
+        static constexpr std::size_t Classes     = MaxSize / Granularity;
+        static constexpr std::size_t ArenaSize   = 64 * 1024;
+
+        struct Block { Block* next; };
+
+        static constexpr std::size_t _class(std::size_t size) { return (size - 1) / Granularity; }
+
+        void* _allocate(std::size_t size);
+        void  _free(void* ptr, std::size_t size);
+        void  _refill(std::size_t size_class);
+
+        std::array<Block*, Classes> _free_lists = { };
+        std::vector<std::unique_ptr<char[]>> _arenas;
+
+        // Remaining space at the end of the last arena
+        char*       _arena_ptr  = nullptr;
+        std::size_t _arena_left = 0;
+
+        Stats _stats;
+    };
+}
+
+namespace S2D::Lua::Lib
+{
+    /**
+     * @brief Lets scripts read their runtime's allocation statistics
+     */
+    struct Memory : Base
+    {
+        static int stats(Lua::State L);
+        Memory();
+    };
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "../Util.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace S2D::Lua
+{
+    /**
+     * @brief Process wide cache of compiled scripts
+     * 
+     * Scripts are parsed once and kept as bytecode, keyed by canonical path. An entry is
+     * stale once the file's write time or size changes, so edited scripts are picked up
+     * without any explicit invalidation. If a directory is set the bytecode is also kept
+     * on disk, so a cold start can skip parsing as well. A file on disk is only used if it
+     * was written for the same path and its bytecode loads, otherwise the source is compiled again.
+     * 
+     * The hot reload watcher compiles from its own thread, so the cache is locked.
+     */
+    struct ChunkCache : Util::NoCopy
+    {
+        using Chunk = std::shared_ptr<const std::string>;
+
+        struct Stats
+        {
+            uint64_t hits      = 0; // Found in memory
+            uint64_t disk_hits = 0; // Found in the cache directory
+            uint64_t misses    = 0; // Parsed from the source file
+        };
+
+        static ChunkCache& instance();
+
+        /**
+         * @brief Get the compiled chunk of a script, compiling it if needed
+         * @param filename Path to the script
+         * @return Util::Result<Chunk> The chunk, or the Lua error code and message
+         */
+        Util::Result<Chunk>
+        get(const std::string& filename);
+
+        /**
+         * @brief Keep compiled chunks in a directory as well, created if it doesn't exist
+         * @param directory The directory, empty to stop using one
+         */
+        void setDirectory(const std::filesystem::path& directory);
+
+        /**
+         * @brief Drop the cached chunk of a file
+         * @param filename Path to the script
+         */
+        void invalidate(const std::filesystem::path& filename);
+        void clear();
+
+        Stats stats() const;
+
+    private:
+        ChunkCache() = default;
+
+        struct Entry
+        {
+            std::filesystem::file_time_type modified;
+            std::uintmax_t size;
+            Chunk chunk;
+        };
+
+        std::filesystem::path _disk_path(const std::string& key) const;
+        bool _read_disk(const std::string& key, Entry& entry) const;
+        void _write_disk(const std::string& key, const Entry& entry) const;
+
+        mutable std::mutex _mutex;
+        std::unordered_map<std::string, Entry> _entries;
+        std::filesystem::path _directory;
+        Stats _stats;
+    };
+}
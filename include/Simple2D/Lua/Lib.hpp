@@ -1,6 +1,7 @@
 #pragma once
 
 #include "TypeMap.hpp"
+#include "TableView.hpp"
 
 #include "../Def.hpp"
 #include "../Util.hpp"
@@ -29,12 +30,33 @@ namespace S2D::Lua::Lib
         static std::tuple<Args...>
         extractArgs(State L);
 
+        /**
+         * @brief Like extractArgs, but leaves the arguments on the stack and reads them in place.
+         *
+         * Tables aren't copied, they come back as views that are valid until the C
+         * function returns. Scalars are read the same way extractArgs reads them.
+         * @tparam Args Types of the arguments
+         * @param L     Lua state
+         * @return std::tuple<ViewType<Args>...> Values (or views) of the Lua arguments
+         */
+        template<typename... Args>
+        static std::tuple<Lua::ViewType<Args>...>
+        viewArgs(State L);
+
         /**
          * @brief Registers the functions in this library with the given runtime.
          * @param runtime Lua runtime to register the functions with
          */
         void registerFunctions(Lua::Runtime& runtime) const;
 
+        /**
+         * @brief Registers the functions in this library as methods of a userdata type.
+         * @param runtime   Lua runtime to register the methods with
+         * @param type_name Name of the userdata type, defaults to the library name
+         */
+        void registerMethods(Lua::Runtime& runtime) const;
+        void registerMethods(Lua::Runtime& runtime, const std::string& type_name) const;
+
         Lua::Table asTable() const;
 
     protected:
@@ -46,6 +68,11 @@ namespace S2D::Lua::Lib
 
         std::string _name;
         Map         _funcs;
+
+    private:
+        template<typename... Args, std::size_t... I>
+        static std::tuple<Lua::ViewType<Args>...>
+        _viewArgs(State L, std::index_sequence<I...>);
     };
 
     namespace detail
@@ -54,6 +81,30 @@ namespace S2D::Lua::Lib
     std::size_t __getTop(State L);
     bool        __isNil(State L);
     void        __pop(State L, uint32_t n);
+    void        __pushValue(State L, int index);
+    bool        __isTable(State L, int index);
+
+    // Reads the argument at the given (1-based) index without removing it
+    template<typename T>
+    Lua::ViewType<T> __viewArg(State L, int index)
+    {
+        if constexpr (std::is_same_v<T, Lua::Table>)
+        {
+            S2D_ASSERT(__isTable(L, index), "Type mismatch");
+            return Lua::TableView(L, index);
+        }
+        else
+        {
+            __pushValue(L, index);
+            S2D_ASSERT(!__isNil(L), "Argument nil");
+            S2D_ASSERT(Lua::CompileTime::TypeMap<T>::check(L), "Type mismatch");
+
+            const auto count = __getTop(L);
+            T value = Lua::CompileTime::TypeMap<T>::construct(L);
+            if (__getTop(L) == count) __pop(L, 1);
+            return value;
+        }
+    }
 
     }
 
@@ -79,4 +130,20 @@ namespace S2D::Lua::Lib
         return values;
     }
 
+    template<typename... Args>
+    std::tuple<Lua::ViewType<Args>...>
+    Base::viewArgs(State L)
+    {
+        S2D_ASSERT(detail::__getTop(L) == sizeof...(Args), "Lua arguments do not match expected args.");
+        return _viewArgs<Args...>(L, std::index_sequence_for<Args...>{});
+    }
+
+    template<typename... Args, std::size_t... I>
+    std::tuple<Lua::ViewType<Args>...>
+    Base::_viewArgs(State L, std::index_sequence<I...>)
+    {
+        // Braced initialization reads the arguments left to right
+        return { detail::__viewArg<Args>(L, (int)I + 1)... };
+    }
+
 } // S2D::Lua::Lib
@@ -5,4 +5,11 @@
 namespace S2D::Lua
 {
     using State = void*;
+
+    /* Types */
+
+    using String = std::string;
+    using Number = float;
+    using Boolean = bool;
+    using Function = int(*)(State);
 }
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "Lib.hpp"
+
+#include "../Util.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace S2D::Lua
+{
+    /**
+     * @brief Sampling profiler for every Lua runtime in the process
+     * 
+     * While running, each state gets a count hook that records the Lua call stack (file,
+     * function and line of every frame) every few thousand instructions. A sample is weighted
+     * by the time since the previous sample, or since the runtime was entered, so time spent
+     * in the engine between calls isn't charged to the scripts. Samples are folded into totals
+     * on a background thread and written out in the folded-stack format flamegraph.pl and
+     * speedscope read.
+     * 
+     * When stopped the hooks are removed, so the only cost left is one atomic load per call
+     * into Lua.
+     */
+    struct Profiler : Util::NoCopy
+    {
+        static Profiler& instance();
+
+        /**
+         * @brief Start sampling every runtime, current and future
+         * @param instructions Number of VM instructions between samples
+         */
+        void start(uint32_t instructions = 10000);
+        void stop();
+
+        static bool running() { return _running.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Write the folded stacks collected so far, one "frame;frame;frame microseconds" per line
+         * @param filename File to write
+         * @return bool Whether the file was written
+         */
+        bool dump(const std::filesystem::path& filename);
+
+        // Drop the collected samples
+        void clear();
+
+        // Called by \ref Runtime
+        void attach(State L);
+        void detach(State L);
+        void enter(State L);
+
+        // Called from the hook, records the current stack of L
+        void sample(State L);
+
+        ~Profiler();
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Sample
+        {
+            std::string stack;
+            uint64_t nanoseconds;
+        };
+
+        Profiler() = default;
+
+        void _aggregate();
+        void _flush();
+
+        inline static std::atomic<bool> _running{ false };
+        uint32_t _instructions = 10000;
+
+        // Time of the last sample (or call into Lua) for each state
+        std::mutex _states_mutex;
+        std::unordered_map<State, Clock::time_point> _states;
+
+        // Samples waiting for the aggregator
+        std::mutex _samples_mutex;
+        std::condition_variable _wake;
+        std::vector<Sample> _samples;
+
+        // Folded stack -> total nanoseconds, only touched by the aggregator and under _folded_mutex
+        std::mutex _folded_mutex;
+        std::unordered_map<std::string, uint64_t> _folded;
+
+        std::thread _thread;
+        bool _quit = false;
+    };
+}
+
+namespace S2D::Lua::Lib
+{
+    /**
+     * @brief Lets scripts start, stop and dump the profiler, e.g. from a debug key
+     */
+    struct Profiling : Base
+    {
+        static int start(Lua::State L);
+        static int stop(Lua::State L);
+        static int dump(Lua::State L);
+        Profiling();
+    };
+}
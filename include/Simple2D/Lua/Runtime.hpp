@@ -1,10 +1,14 @@
 #pragma once
 
 #include <filesystem>
+#include <vector>
 
 #include "../Util.hpp"
 
+#include "Allocator.hpp"
+#include "ChunkCache.hpp"
 #include "Lib.hpp"
+#include "Profiler.hpp"
 #include "TypeMap.hpp"
 
 #define LUA_HOT_RELOAD
@@ -29,11 +33,22 @@ namespace S2D::Lua
         template<typename T>
         using Result = Util::Result<T, Util::Error<ErrorCode>>;
 
+        /**
+         * @brief An environment the script has been run in.
+         * 
+         * \ref Global is the runtime's own global table. Every instance made with \ref createInstance
+         * runs the script again inside its own table (falling back to the globals for lookups), so
+         * many entities can share one runtime without sharing their script variables.
+         */
+        enum class Instance : uint32_t { Global = 0 };
+
         /**
          * @brief Construct a Lua runtime from a script
-         * @param filename File path to the script
+         * @param filename  File path to the script
+         * @param instanced If set the script is only compiled, it runs when \ref createInstance is called
+         *                  (after the libraries and globals are registered) instead of in the global table
          */
-        Runtime(const std::string& filename);
+        Runtime(const std::string& filename, bool instanced = false);
         
         Runtime(Runtime&& r);
         ~Runtime();
@@ -41,11 +56,12 @@ namespace S2D::Lua
         /**
          * @brief Creates a runtime with the given Libraries loaded into it.
          * @tparam Libraries List of library types that are derived from \ref Lua::Lib::Base.
-         * @param filename Name of the file to load into the runtime
+         * @param filename  Name of the file to load into the runtime
+         * @param instanced See \ref Runtime(const std::string&, bool)
          * @return Runtime The created runtime 
          */
         template<typename... Libraries>
-        static Runtime create(const std::string& filename);
+        static Runtime create(const std::string& filename, bool instanced = false);
 
         /**
          * @brief Registers a C++ function for use in the Lua runtime
@@ -60,6 +76,25 @@ namespace S2D::Lua
             const std::string& func_name,
             Lua::Function function);
 
+        /**
+         * @brief Registers a C++ function as a method on a userdata type
+         * 
+         * The method lives in the __index table of the metatable named type_name, which is
+         * created the first time it is referenced. Names starting with "__" are metamethods
+         * and are set on the metatable itself. Userdata pushed with \ref Lua::pushCachedUserdata
+         * under the same name share this metatable.
+         * 
+         * @param type_name Name of the metatable
+         * @param func_name Name of the method in Lua
+         * @param function Pointer to a static function
+         * @return Result<void> Returns if an error has occured
+         */
+        Result<void>
+        registerMethod(
+            const std::string& type_name,
+            const std::string& func_name,
+            Lua::Function function);
+
         /**
          * @brief Get a global variable by name from runtime
          * @tparam T Type of the global variable (supported types in Lua namespace)
@@ -70,9 +105,16 @@ namespace S2D::Lua
         Result<T>
         getGlobal(const std::string& name);
 
-        // TODO: Need to load globals in datastructure so that the file can be hot-reloaded
-        // when the lua state is reloaded, the globals that have been loaded in need to be 
-        // transferred
+        /**
+         * @brief Get a global variable from an instance's environment
+         * @tparam T Type of the variable (supported types in Lua namespace)
+         * @param instance The instance
+         * @param name     Name of the variable
+         * @return Result<T> The value of the variable or error
+         */
+        template<typename T>
+        Result<T>
+        getGlobal(Instance instance, const std::string& name);
 
         /**
          * @brief Set a global variable from a value to a name
@@ -85,6 +127,69 @@ namespace S2D::Lua
         Result<void>
         setGlobal(const std::string& name, const T& value);
 
+        /**
+         * @brief Set a global variable in an instance's environment
+         * @tparam T Type of the variable (anything with a \ref CompileTime::TypeMap)
+         * @param instance The instance
+         * @param name     Name of the variable
+         * @param value    Value of the variable
+         * @return Result<void> The status of the operation
+         */
+        template<typename T>
+        Result<void>
+        setGlobal(Instance instance, const std::string& name, const T& value);
+
+        /**
+         * @brief Runs a chunk of Lua source in the global table
+         * @param code Source code
+         * @param name Name of the chunk used in error messages
+         * @return Result<void> FunctionError if the chunk failed to load or run
+         */
+        Result<void>
+        runString(const std::string& code, const std::string& name);
+
+        /**
+         * @brief Runs the script again in a new environment
+         * @return Result<Instance> The new instance or FunctionError if the script failed
+         */
+        Result<Instance>
+        createInstance();
+
+        /**
+         * @brief Releases an instance's environment and its cached functions
+         * @param instance The instance, \ref Instance::Global is ignored
+         */
+        void destroyInstance(Instance instance);
+
+        /**
+         * @brief Puts an instance back in the state a new one starts in, so it can be reused
+         * 
+         * An instance's environment is emptied and the script runs in it again. The global
+         * table keeps the libraries, so for \ref Instance::Global the script only runs again.
+         * 
+         * @param instance The instance
+         * @return Result<void> FunctionError if the script fails to run
+         */
+        Result<void>
+        resetInstance(Instance instance);
+
+        /**
+         * @brief Get the number of instances alive in this runtime, not including the global one
+         */
+        std::size_t instanceCount() const;
+
+        /**
+         * @brief Get the number of bytes the Lua state is using
+         */
+        std::size_t memoryUsage() const;
+
+        /**
+         * @brief Get the allocation counters of this runtime's Lua state
+         * 
+         * Under LuaJIT the state keeps its own allocator, so only the live bytes are filled in.
+         */
+        Allocator::Stats memoryStats() const;
+
         /**
          * @brief Invokes a Lua function from this environment
          * @tparam Return Expected return types from the function 
@@ -99,19 +204,132 @@ namespace S2D::Lua
             const std::string& name,
             Args&&... args);
 
+        /**
+         * @brief Resolves a global function once and keeps a registry reference to it in a slot
+         * 
+         * Calling through the slot skips the global lookup, and \ref hasFunction lets the caller
+         * skip functions the script doesn't define without building an error.
+         * 
+         * @param slot Index of the slot (less than \ref MaxFunctionSlots)
+         * @param name Name of the function
+         * @return Result<void> NotFunction if the global isn't a function
+         */
+        Result<void>
+        cacheFunction(uint32_t slot, const std::string& name);
+
+        /**
+         * @brief Re-resolves every cached function slot in every instance, needed after the script is reloaded
+         */
+        void resolveFunctions();
+
+        /**
+         * @brief Check if the cached function slot points at a function
+         * @param slot     Index of the slot
+         * @param instance Instance to check in
+         * @return bool Whether the function exists
+         */
+        bool hasFunction(uint32_t slot, Instance instance = Instance::Global) const;
+
+        /**
+         * @brief Invokes a cached Lua function from this environment
+         * @tparam Return Expected return types from the function 
+         * @tparam Args   Arguments to pass into the function
+         * @param slot Slot the function was cached in with \ref cacheFunction
+         * @param args Values of the arguments
+         * @return Result<std::tuple<Return...>> Contains the values returned from the function or error
+         */
+        template<typename... Return, typename... Args>
+        Result<std::tuple<Return...>>
+        runFunction(
+            uint32_t slot,
+            Args&&... args);
+
+        /**
+         * @brief Invokes a cached Lua function defined by an instance
+         * @tparam Return Expected return types from the function 
+         * @tparam Args   Arguments to pass into the function
+         * @param instance Instance made with \ref createInstance
+         * @param slot     Slot the function was cached in with \ref cacheFunction
+         * @param args     Values of the arguments
+         * @return Result<std::tuple<Return...>> Contains the values returned from the function or error
+         */
+        template<typename... Return, typename... Args>
+        Result<std::tuple<Return...>>
+        runFunction(
+            Instance instance,
+            uint32_t slot,
+            Args&&... args);
+
+        static constexpr uint32_t MaxFunctionSlots = 32;
+
+        /**
+         * @brief Compiles a script into a chunk that can be handed to \ref reload
+         * 
+         * Goes through \ref ChunkCache, so it is safe to call from another thread and the
+         * new chunk is what later runtimes of the same file load.
+         * 
+         * @param filename Path to the script
+         * @return Result<std::string> The compiled chunk or FunctionError with the syntax error
+         */
+        static Result<std::string>
+        compile(const std::string& filename);
+
+        /**
+         * @brief Swaps a newly compiled version of the script into the runtime
+         * 
+         * The chunk runs again in the global table (unless the runtime is instanced) and in every
+         * instance. Afterwards the values that aren't functions are put back, so only the code
+         * changes and the script's variables carry across. Top level locals start over.
+         * 
+         * @param chunk Chunk made by \ref compile
+         * @return Result<void> FunctionError if the chunk failed to run in an environment
+         */
+        Result<void>
+        reload(const std::string& chunk);
+
         bool     good() const;
         operator bool() const;
 
 
         const auto& filename() const { return _filename; }
+        const auto& path()     const { return _path; }
 
     private:
+        template<typename... Return, typename... Args>
+        Result<std::tuple<Return...>>
+        _run_pushed(Args&&... args);
+
+        struct Environment
+        {
+            int table; // Registry reference to the environment table
+
+            // Registry references for cached functions and which ones exist
+            std::vector<int> function_refs;
+            uint32_t function_mask;
+        };
+
         void _pop(std::size_t n = 1) const;
         int _call_func(uint32_t args, uint32_t ret) const;
+        void _push_ref(int ref) const;
+        bool _resolve(Environment& environment, uint32_t slot);
+        void _set_field(Instance instance, const std::string& name);
+        bool _run_chunk(const std::string& chunk, const Environment& environment, bool keep_values = true);
+
+        // Declared before the state so it outlives it
+        std::unique_ptr<Allocator> _allocator;
 
         State L;
         bool _good;
+        bool _instanced;
         std::string _filename;
+        std::filesystem::path _path;
+
+        // The compiled script, instances load it again instead of reparsing the file
+        std::string _chunk;
+
+        std::vector<std::string> _function_names;
+        std::vector<Environment> _environments;
+        std::vector<uint32_t>    _free_environments;
 
 #   ifdef LUA_HOT_RELOAD
         std::filesystem::file_time_type _last_modified;
@@ -119,11 +337,11 @@ namespace S2D::Lua
     };
 
     template<typename... Libraries>
-    Runtime Runtime::create(const std::string& filename)
+    Runtime Runtime::create(const std::string& filename, bool instanced)
     {
         using namespace Util::CompileTime;
 
-        Runtime runtime(filename);
+        Runtime runtime(filename, instanced);
 
         static_for<sizeof...(Libraries)>([&](auto n) 
         {
@@ -150,14 +368,57 @@ namespace S2D::Lua
             else return { glob_res.error() };
         }
 
-        auto args_set = std::tuple(std::forward<Args>(args)...);
+        return _run_pushed<Return...>(std::forward<Args>(args)...);
+    }
+
+    template<typename... Return, typename... Args>
+    Runtime::Result<std::tuple<Return...>>
+    Runtime::runFunction(
+        uint32_t slot,
+        Args&&... args)
+    {
+        return runFunction<Return...>(Instance::Global, slot, std::forward<Args>(args)...);
+    }
+
+    template<typename... Return, typename... Args>
+    Runtime::Result<std::tuple<Return...>>
+    Runtime::runFunction(
+        Instance instance,
+        uint32_t slot,
+        Args&&... args)
+    {
+        if (!hasFunction(slot, instance)) return { Runtime::ErrorCode::NotFunction };
+
+        _push_ref(_environments[(uint32_t)instance].function_refs[slot]);
+        return _run_pushed<Return...>(std::forward<Args>(args)...);
+    }
+
+    template<typename T>
+    Runtime::Result<void>
+    Runtime::setGlobal(Instance instance, const std::string& name, const T& value)
+    {
+        CompileTime::TypeMap<T>::push(L, value);
+        _set_field(instance, name);
+        return { };
+    }
+
+    template<typename... Return, typename... Args>
+    Runtime::Result<std::tuple<Return...>>
+    Runtime::_run_pushed(Args&&... args)
+    {
+        auto args_set = std::forward_as_tuple(std::forward<Args>(args)...);
         Util::CompileTime::static_for<sizeof...(args)>([&](auto n){
             constexpr std::size_t I = n;
-            using Type = std::remove_reference_t<Util::CompileTime::NthType<I, Args...>>;
+            using Type = std::remove_cv_t<std::remove_reference_t<Util::CompileTime::NthType<I, Args...>>>;
             CompileTime::TypeMap<Type>::push(L, std::get<I>(args_set));
         });
 
-        if (_call_func(sizeof...(Args), sizeof...(Return)) != 0) return { { ErrorCode::FunctionError, CompileTime::TypeMap<Lua::String>::construct(L) } };
+        if (_call_func(sizeof...(Args), sizeof...(Return)) != 0)
+        {
+            auto message = CompileTime::TypeMap<Lua::String>::construct(L);
+            _pop();
+            return { { ErrorCode::FunctionError, message } };
+        }
         
         bool err = false;
         auto left = sizeof...(Return);
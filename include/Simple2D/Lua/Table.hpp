@@ -2,7 +2,9 @@
 
 #include "Lua.hpp"
 
-#include <unordered_map>
+#include <functional>
+#include <variant>
+#include <vector>
 #include <memory>
 
 namespace S2D::Lua
@@ -11,10 +13,24 @@ namespace S2D::Lua
     {
         /**
          * @brief Represents a value in the table stored in memory with a type.
+         *
+         * Scalars (numbers, booleans, functions and pointers) are stored inline,
+         * only strings that outgrow the small-string buffer and nested tables
+         * touch the heap.
          */
         struct Data
         {
-            std::shared_ptr<void> data;
+            using Value = std::variant<
+                std::monostate,
+                Lua::Number,
+                Lua::Boolean,
+                Lua::Function,
+                void*,
+                Lua::String,
+                std::shared_ptr<Table>
+            >;
+
+            Value value;
             int type;
 
             /**
@@ -25,35 +41,36 @@ namespace S2D::Lua
              */
             template<typename T>
             static Data fromValue(const T& value);
-
-            /**
-             * @brief Allocate room and copy the memory of a given value
-             * @tparam T    Type of the entry
-             * @param value Value of the entry
-             * @return std::shared_ptr<void> Pointer to the allocated entry
-             */
-            template<typename T>
-            static std::shared_ptr<void> emplace(const T& value);
         };
 
-        using Map = std::unordered_map<std::string, Data>;
+        /**
+         * @brief Flat key-value storage, tables coming from Lua are small so a
+         *        linear scan beats hashing the key
+         */
+        using Entry = std::pair<Lua::String, Data>;
+        using Map   = std::vector<Entry>;
 
         Table() = default;
         Table(const Map& map);
 
         /**
          * @brief Constructs a table from the current Lua stack
-         * 
+         *
          * This assumes that there is a table already at index -1 in the Lua
          * stack. Once executed, it pops the table off the stack completely.
-         * 
-         * @param L 
+         *
+         * @param L
          */
         Table(State L);
         ~Table() = default;
 
         const Data& getRaw(const std::string& name) const;
 
+        /**
+         * @brief Iterate over the array part of the table (keys 1..n)
+         * @tparam T     Type of the values in the array
+         * @param lambda Function taking the (1-based) index and the value
+         */
         template<typename T>
         void each(std::function<void(uint32_t, T&)> lambda);
 
@@ -115,6 +132,40 @@ namespace S2D::Lua
         void set(const std::string& name, const T& value);
         void set(const std::string& name, void* value);
 
+        /**
+         * @brief Get a reference to a value in the array part of the table
+         * @tparam T    Type of the value (with Lua:: prefix)
+         * @param index The (1-based, like Lua) index of the value
+         * @return T&   The reference to the value
+         */
+        template<typename T>
+        T& get(uint32_t index);
+
+        template<typename T>
+        const T& get(uint32_t index) const;
+
+        /**
+         * @brief Append a value to the array part of the table
+         * @tparam T The type of the value (with Lua:: prefix)
+         * @param value The value
+         */
+        template<typename T>
+        void push(const T& value);
+        void push(void* value);
+
+        /**
+         * @brief Get the length of the array part of the table
+         * @return std::size_t The number of entries with keys 1..n
+         */
+        std::size_t size() const;
+
+        /**
+         * @brief Reserve room for a number of entries
+         * @param count Number of entries expected
+         */
+        void reserve(std::size_t count);
+        void reserve(std::size_t array_count, std::size_t count);
+
         /**
          * @brief Get the raw mapping of this table
          * @return const Map& The map in this table
@@ -126,8 +177,13 @@ namespace S2D::Lua
          * @param L The Lua state to dump the table onto
          */
         void toStack(State L) const;
-    
+
     private:
+        Data*       _find(const std::string& name);
+        const Data* _find(const std::string& name) const;
+        void        _insert(const std::string& name, Data&& data);
+
+        std::vector<Data> array;
         Map dictionary;
     };
 }
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Lua.hpp"
+#include "Table.hpp"
+
+#include <functional>
+
+namespace S2D::Lua
+{
+    struct TableView;
+
+    /**
+     * @brief Maps a type requested from a table onto the type handed back by a view,
+     *        nested tables are viewed in place instead of copied
+     */
+    template<typename T>
+    struct View { using Type = T; };
+
+    template<>
+    struct View<Table> { using Type = TableView; };
+
+    template<typename T>
+    using ViewType = typename View<T>::Type;
+
+    /**
+     * @brief Non-owning view over a table sitting on the Lua stack
+     *
+     * Unlike Table, nothing is copied up front: each get() reads the field straight
+     * from the stack. Scalars are popped right after being read, nested tables are
+     * left on the stack so they can be viewed as well. A view (and every nested view
+     * made from it) is only valid until the C function that made it returns.
+     */
+    struct TableView
+    {
+        /**
+         * @brief Views the table at the given stack index
+         * @param L     Lua state
+         * @param index Index of the table in the stack, relative indices are made absolute
+         */
+        TableView(State L, int index);
+
+        /**
+         * @brief Read a value from the table
+         * @tparam T   Type of the value (with Lua:: prefix)
+         * @param name The value's key
+         * @return ViewType<T> The value, or a view if T is Lua::Table
+         */
+        template<typename T>
+        ViewType<T> get(const std::string& name) const;
+
+        /**
+         * @brief Read a value from the array part of the table
+         * @tparam T    Type of the value (with Lua:: prefix)
+         * @param index The (1-based, like Lua) index of the value
+         * @return ViewType<T> The value, or a view if T is Lua::Table
+         */
+        template<typename T>
+        ViewType<T> get(uint32_t index) const;
+
+        template<typename T>
+        void try_get(const std::string& name, std::function<void(const ViewType<T>&)> lambda) const;
+
+        bool hasValue(const std::string& name) const;
+
+        /**
+         * @brief Get the length of the array part of the table
+         * @return std::size_t The number of entries with keys 1..n
+         */
+        std::size_t size() const;
+
+        /**
+         * @brief Copy the viewed table into an owning table
+         * @return Table The copy
+         */
+        Table toTable() const;
+
+        int index() const { return _index; }
+
+    private:
+        // Reads the value at the top of the stack, pops it unless it's a table
+        template<typename T>
+        ViewType<T> _take(int type) const;
+
+        State L;
+        int _index;
+    };
+}
@@ -5,13 +5,6 @@
 
 namespace S2D::Lua
 {
-    /* Types */
-
-    using String = std::string;
-    using Number = float;
-    using Boolean = bool;
-    using Function = int(*)(Lua::State);
-
 namespace CompileTime
 {
     template<typename T>
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Lua.hpp"
+
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+namespace S2D::Lua
+{
+    namespace detail
+    {
+    
+    void* __pushUserdata(State L, const char* type_name, std::size_t size);
+    void* __pushCachedUserdata(State L, const char* type_name, int64_t key, std::size_t size);
+    void* __testUserdata(State L, const char* type_name, int index);
+
+    }
+
+    /**
+     * @brief Pushes a new full userdata onto the stack with the metatable registered under type_name
+     * @tparam T        Trivially copyable type stored in the block
+     * @param L         Lua state
+     * @param type_name Name of the metatable
+     * @param value     Value to store in the block
+     */
+    template<typename T>
+    void pushUserdata(State L, const char* type_name, const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        new (detail::__pushUserdata(L, type_name, sizeof(T))) T(value);
+    }
+
+    /**
+     * @brief Pushes a full userdata onto the stack that is cached in the registry by key.
+     * 
+     * The first push for a key allocates the block and gives it the metatable registered
+     * under type_name (see \ref Runtime::registerMethod), every push after that reuses the
+     * same block so handing it to Lua each frame allocates nothing. The cache holds the blocks
+     * weakly, keep a reference in Lua (like an instance's self) to pin one.
+     * 
+     * @tparam T        Trivially copyable type stored in the block
+     * @param L         Lua state
+     * @param type_name Name of the metatable
+     * @param key       Key identifying this object in the cache
+     * @param value     Value to store in the block
+     */
+    template<typename T>
+    void pushCachedUserdata(State L, const char* type_name, int64_t key, const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        new (detail::__pushCachedUserdata(L, type_name, key, sizeof(T))) T(value);
+    }
+
+    /**
+     * @brief Get a pointer to the userdata at the index if it has the given metatable
+     * @tparam T        Type stored in the block
+     * @param L         Lua state
+     * @param type_name Name of the metatable
+     * @param index     Stack index
+     * @return T* Pointer to the block or nullptr if it is not of the type
+     */
+    template<typename T>
+    T* toUserdata(State L, const char* type_name, int index = -1)
+    {
+        return static_cast<T*>(detail::__testUserdata(L, type_name, index));
+    }
+}
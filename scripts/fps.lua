@@ -2,7 +2,7 @@ function Update(world, entity)
     local text = entity:getComponent(Component.Text)
     Debug.assert(text.good)
 
-    text.string = "FPS: "..string.format("%.1f", 1.0 / Time.deltaTime())
+    text.string = "FPS: "..string.format("%.1f", Time.renderRate())
     entity:setComponent(text)
 end
 
@@ -27,15 +27,14 @@ function Update(world, entity)
         force.y = force.y - 1
     end
 
-    local rigidbody = entity:getComponent(Component.Rigidbody)
+    -- Parallel scripts get no reference and write a copy back instead
+    local rigidbody = entity:getComponentRef(Component.Rigidbody) or entity:getComponent(Component.Rigidbody)
 
     local magnitude = 4000
     force = Math.normalize(force)
     force.x = force.x * magnitude
     force.y = force.y * magnitude
 
-    rigidbody.addedForce.x = force.x;
-    rigidbody.addedForce.y = force.y;
-    
+    rigidbody.addedForce = force
     entity:setComponent(rigidbody)
 end
\ No newline at end of file
@@ -62,7 +62,7 @@ function GetEntities()
                 },
                 {
                     type = Component.Collider,
-                    value = { ColliderComponent = Component.Tilemap }
+                    value = { ColliderComponent = Component.Tilemap, Static = true }
                 }
             },
             scripts = {
@@ -0,0 +1,158 @@
+#include <Simple2D/Engine/Commands.hpp>
+#include <Simple2D/Engine/Components.hpp>
+#include <Simple2D/Engine/Events.hpp>
+
+#include <Simple2D/Engine/LuaLib/World.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+
+namespace S2D::Engine
+{
+
+/* struct CommandBuffer */
+void CommandBuffer::destroy(flecs::entity_t entity)
+{
+    const auto index = (uint32_t)entity;
+    if (index >= pending.size()) pending.resize(std::max<std::size_t>(index + 1, pending.size() * 2));
+    if (pending[index]) return;
+
+    pending[index] = 1;
+    destroys.push_back(entity);
+}
+
+bool CommandBuffer::isDestroyed(flecs::entity_t entity) const
+{
+    const auto index = (uint32_t)entity;
+    return (index < pending.size() && pending[index]);
+}
+
+CommandBuffer& commandBuffer(flecs::world& world)
+{
+    if (!world.has<CommandBuffer>()) world.set<CommandBuffer>({});
+    return *world.get_mut<CommandBuffer>();
+}
+
+// Commands queued from the workers of the parallel phase, applied at the next flush
+enum class DeferredOp { Create, Destroy };
+static std::mutex deferred_mutex;
+static std::vector<std::tuple<flecs::world_t*, DeferredOp, flecs::entity_t>> deferred_commands;
+
+flecs::entity createEntity(flecs::world& world, const std::vector<flecs::id_t>& ids)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    // Every ID goes in the description, so the entity lands in its final table in one move
+    ecs_entity_desc_t desc = {};
+    const std::size_t count = std::min<std::size_t>(ids.size(), FLECS_ID_DESC_MAX - 1);
+    std::copy_n(ids.begin(), count, desc.add);
+
+    flecs::entity entity(world, ecs_entity_init(world.c_ptr(), &desc));
+    for (std::size_t i = count; i < ids.size(); i++) entity.add(ids[i]);
+
+    auto* real_world = const_cast<flecs::world_t*>(ecs_get_world(world.c_ptr()));
+    if (real_world != world.c_ptr())
+    {
+        std::scoped_lock lock(deferred_mutex);
+        deferred_commands.emplace_back(real_world, DeferredOp::Create, entity.raw_id());
+        return entity;
+    }
+
+    auto& buffer = commandBuffer(world);
+    buffer.created++;
+    buffer.create_time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count() / 1e3;
+    return entity;
+}
+
+void queueDestroy(flecs::world_t* world, flecs::entity_t entity)
+{
+    if (stage(world) != world)
+    {
+        std::scoped_lock lock(deferred_mutex);
+        deferred_commands.emplace_back(world, DeferredOp::Destroy, entity);
+        return;
+    }
+
+    flecs::world w(world);
+    if (!w.is_alive(entity)) return;
+    commandBuffer(w).destroy(entity);
+}
+
+bool isDestroyQueued(flecs::world& world, flecs::entity_t entity)
+{
+    if (!world.has<CommandBuffer>()) return false;
+    return world.get<CommandBuffer>()->isDestroyed(entity);
+}
+
+static void applyDeferred(flecs::world& world, CommandBuffer& buffer)
+{
+    decltype(deferred_commands) deferred;
+    {
+        std::scoped_lock lock(deferred_mutex);
+        if (deferred_commands.empty()) return;
+
+        // Leave the ones for other worlds where they are
+        auto it = std::stable_partition(deferred_commands.begin(), deferred_commands.end(),
+            [&](const auto& command) { return std::get<0>(command) != world.c_ptr(); });
+        deferred.assign(it, deferred_commands.end());
+        deferred_commands.erase(it, deferred_commands.end());
+    }
+
+    for (const auto& [w, op, entity] : deferred)
+    {
+        switch (op)
+        {
+        case DeferredOp::Create:  buffer.created++; break;
+        case DeferredOp::Destroy: if (world.is_alive(entity)) buffer.destroy(entity); break;
+        }
+    }
+}
+
+uint64_t flushCommands(const WorldHandle& world_handle)
+{
+    auto world = flecs::world(world_handle.world);
+    auto& buffer = commandBuffer(world);
+    applyDeferred(world, buffer);
+    if (buffer.destroys.empty()) return 0;
+
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    // Taken out so a Reset(...) destroying something else queues it for the next flush
+    auto destroys = std::move(buffer.destroys);
+    buffer.destroys.clear();
+
+    auto* bus = (world.has<EventBus>() ? world.get_mut<EventBus>() : nullptr);
+    for (const auto id : destroys)
+    {
+        flecs::entity e(world, id);
+        if (!e.is_alive()) continue;
+
+        if (bus)
+        {
+            Event destroyed;
+            destroyed.type   = (uint32_t)EventType::Destroy;
+            destroyed.source = id;
+            bus->push(destroyed);
+        }
+
+        // Hand the scripts to the pool so the next spawn of the same file skips creating one
+        if (e.has<Script>()) recycleScript(world_handle, e, *e.get_mut<Script>());
+    }
+
+    // Deleted together, so the cleanup of the tables they leave runs once
+    world.defer_begin();
+    for (const auto id : destroys)
+    {
+        buffer.pending[(uint32_t)id] = 0;
+        if (world.is_alive(id)) ecs_delete(world.c_ptr(), id);
+    }
+    world.defer_end();
+
+    buffer.destroyed += destroys.size();
+    buffer.flushes++;
+    buffer.flush_time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count() / 1e3;
+    return destroys.size();
+}
+
+}
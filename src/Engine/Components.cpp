@@ -1,7 +1,13 @@
 #include <Simple2D/Engine/Components.hpp>
+#include <Simple2D/Engine/HotReload.hpp>
+#include <Simple2D/Engine/Schema.hpp>
 
 #include <Simple2D/Engine/LuaLib/Time.hpp>
 #include <Simple2D/Engine/LuaLib/Entity.hpp>
+#include <Simple2D/Engine/LuaLib/ComponentRef.hpp>
+#include <Simple2D/Engine/LuaLib/Events.hpp>
+#include <Simple2D/Engine/LuaLib/System.hpp>
+#include <Simple2D/Engine/LuaLib/World.hpp>
 #include <Simple2D/Engine/LuaLib/Input.hpp>
 #include <Simple2D/Engine/LuaLib/Math.hpp>
 #include <Simple2D/Engine/LuaLib/MeshLib.hpp>
@@ -14,17 +20,162 @@
 
 #include <flecs.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <sstream>
+
 namespace S2D::Engine
 {
 
+const Field*
+Field::find(const char* name) const
+{
+    for (const auto& field : fields)
+        if (!strcmp(field.name, name)) return &field;
+    return nullptr;
+}
+
+/* Layouts of the vector types, named like the keys in the component tables */
+template<typename T>
+static std::vector<Field>
+positionFields(Field::Type type)
+{
+    return {
+        { "x", offsetof(T, x), type },
+        { "y", offsetof(T, y), type },
+        { "z", offsetof(T, z), type }
+    };
+}
+
+template<typename T>
+static std::vector<Field>
+sizeFields(Field::Type type)
+{
+    return {
+        { "width",  offsetof(T, x), type },
+        { "height", offsetof(T, y), type }
+    };
+}
+
+#ifdef S2D_LUAJIT
+static std::size_t
+fieldSize(const Field& field)
+{
+    switch (field.type)
+    {
+    case Field::Type::Number:   return sizeof(Lua::Number);
+    case Field::Type::Unsigned: return sizeof(uint32_t);
+    case Field::Type::Enum:     return sizeof(int32_t);
+    case Field::Type::Boolean:  return sizeof(Lua::Boolean);
+    case Field::Type::String:   return 0;
+    case Field::Type::Struct:
+    {
+        std::size_t size = 0;
+        for (const auto& member : field.fields) size = std::max(size, member.offset + fieldSize(member));
+        return size;
+    }
+    }
+    return 0;
+}
+
+/* Declares the members of a struct in C, anything FFI can't map (strings) is left as padding */
+static void
+declareFields(std::stringstream& out, const std::vector<Field>& fields, std::size_t size)
+{
+    std::vector<const Field*> sorted;
+    for (const auto& field : fields) sorted.push_back(&field);
+    std::sort(sorted.begin(), sorted.end(), [](const Field* a, const Field* b) { return a->offset < b->offset; });
+
+    std::size_t cursor  = 0;
+    uint32_t    padding = 0;
+    const auto pad = [&](std::size_t offset)
+    {
+        if (offset > cursor) out << "uint8_t _pad" << padding++ << "[" << offset - cursor << "]; ";
+        cursor = offset;
+    };
+
+    for (const auto* field : sorted)
+    {
+        if (field->offset < cursor || field->type == Field::Type::String) continue;
+
+        pad(field->offset);
+        switch (field->type)
+        {
+        case Field::Type::Number:   out << "float ";    break;
+        case Field::Type::Unsigned: out << "uint32_t "; break;
+        case Field::Type::Enum:     out << "int32_t ";  break;
+        case Field::Type::Boolean:  out << "bool ";     break;
+        case Field::Type::Struct:
+            out << "struct { ";
+            declareFields(out, field->fields, fieldSize(*field));
+            out << "} ";
+            break;
+        default: break;
+        }
+        out << field->name << "; ";
+        cursor += fieldSize(*field);
+    }
+
+    pad(size);
+}
+
+/* Lua that declares every component as an FFI struct and the helpers to view them in place */
+static std::string
+ffiPrelude(flecs::world& world)
+{
+    using namespace Util::CompileTime;
+
+    std::stringstream cdef, types;
+    static_for<(int)Name::Count>([&](auto n)
+    {
+        constexpr std::size_t i = n;
+        constexpr auto component = static_cast<Name>(i);
+
+        cdef << "typedef struct { ";
+        declareFields(cdef, Component<component>::getLayout().fields, sizeof(ComponentData<component>));
+        cdef << "} S2D_" << *component << ";\n";
+
+        types << "    [" << world.component<ComponentData<component>>().raw_id() << "] = ffi.typeof(\"S2D_" << *component << "*\"),\n";
+    });
+
+    std::stringstream prelude;
+    prelude << "local ffi = require(\"ffi\")\n"
+            << "ffi.cdef[[\n" << cdef.str() << "]]\n"
+            << "ComponentPointer = {\n" << types.str() << "}\n"
+            << "function ComponentView(entity, type)\n"
+            << "    local ptr = entity:getComponentPtr(type)\n"
+            << "    return ptr and ffi.cast(ComponentPointer[type], ptr)\n"
+            << "end\n"
+            << "function ColumnView(iter, k)\n"
+            << "    local ptr, type = iter:fieldPtr(k)\n"
+            << "    return ptr and ffi.cast(ComponentPointer[type], ptr)\n"
+            << "end\n";
+
+    return prelude.str();
+}
+#endif
+
 std::unique_ptr<Lua::Runtime>
-loadRuntime(const std::string& filename, flecs::world& world)
+loadRuntime(const std::string& filename, flecs::world& world, bool instanced)
 {
     return std::make_unique<Lua::Runtime>([&]()
     {
         auto runtime = Lua::Runtime::create<
-            Log::Library, Time, Engine::Input, Engine::Math
-        >(filename);
+            Log::Library, Lua::Lib::Memory, Lua::Lib::Profiling, Time, Engine::Input, Engine::Math
+        >(filename, instanced);
+
+        /* The entity and world handle types */
+        Engine::Entity().registerMethods(runtime);
+        Engine::World().registerMethods(runtime);
+        Engine::ComponentRef().registerMethods(runtime);
+        Engine::System().registerMethods(runtime);
+        Engine::Column().registerMethods(runtime);
+        Engine::ResLib().registerMethods(runtime, WorldHandle::TypeName);
+        Engine::Events().registerMethods(runtime, EntityHandle::TypeName);
+        Engine::EventBatch().registerMethods(runtime);
 
         /* The component name enum */
         Lua::Table component;
@@ -42,46 +193,359 @@ loadRuntime(const std::string& filename, flecs::world& world)
         Directory.set<Lua::String>("Source", Script::SourceDir);
         runtime.setGlobal("Directory", Directory);
 
-        globalEnum<Primitive>   (runtime, "PrimitiveType");
-        globalEnum<ResourceType>(runtime, "ResourceType");
-        globalEnum<Projection>  (runtime, "ProjectionType");
+        globalEnum<Primitive>    (runtime, "PrimitiveType");
+        globalEnum<ResourceType> (runtime, "ResourceType");
+        globalEnum<Projection>   (runtime, "ProjectionType");
+        globalEnum<ColliderShape>(runtime, "ColliderShape");
+
+#       ifdef S2D_LUAJIT
+        /* FFI structs over the component storage */
+        const auto prelude = runtime.runString(ffiPrelude(world), "=components");
+        if (!prelude)
+            Log::Logger::instance("engine")->error("Error declaring FFI components: {}", prelude.error().message());
+#       endif
+
+        /* Resolve the engine callbacks once so they aren't looked up every frame */
+        for (uint32_t i = 0; i < (uint32_t)ScriptFunction::Count; i++)
+            runtime.cacheFunction(i, *(ScriptFunction)i);
+
+#       ifdef LUA_HOT_RELOAD
+        HotReload::instance().watch(filename);
+#       endif
 
         return runtime;
     }());
 }
 
-void loadScript(const std::string& filename, flecs::world& world, Script& script)
+static std::shared_ptr<Lua::Runtime>
+sharedRuntime(const std::string& filename, flecs::world& world)
 {
-    script.runtime.push_back(std::pair(
-        loadRuntime(filename, world), 
-        false
-    ));
+    if (!world.has<ScriptCache>()) world.set<ScriptCache>({});
+    auto& runtime = world.get_mut<ScriptCache>()->runtimes[filename];
+    if (!runtime) runtime = loadRuntime(filename, world, true);
+    return runtime;
 }
 
-void
-setComponentFromTable(
-    const Lua::Table& table, 
-    void* _data, 
-    flecs::id_t component_id, 
-    flecs::world& world)
+Script::Instance::Instance(std::shared_ptr<Lua::Runtime> runtime, Lua::Runtime::Instance env) :
+    runtime(std::move(runtime)),
+    env(env)
+{   }
+
+Script::Instance::Instance(Instance&& instance) :
+    runtime(std::move(instance.runtime)),
+    env(instance.env),
+    started(instance.started)
 {
-    using namespace Util::CompileTime;
+    instance.env = Lua::Runtime::Instance::Global;
+}
 
-    bool found = false;
-    static_for<(int)Name::Count>([&](auto n)
+Script::Instance& 
+Script::Instance::operator=(Instance&& instance)
+{
+    if (this == &instance) return *this;
+
+    if (runtime) runtime->destroyInstance(env);
+    runtime = std::move(instance.runtime);
+    env     = instance.env;
+    started = instance.started;
+    instance.env = Lua::Runtime::Instance::Global;
+
+    return *this;
+}
+
+Script::Instance::~Instance()
+{
+    if (runtime) runtime->destroyInstance(env);
+}
+
+static std::optional<Script::Instance>
+pooledScript(const std::string& path, flecs::world& world)
+{
+    if (!ScriptPool::Enabled) return std::nullopt;
+    if (!world.has<ScriptPool>()) world.set<ScriptPool>({});
+
+    auto* pool = world.get_mut<ScriptPool>();
+    const auto it = pool->free.find(path);
+    if (it == pool->free.end() || it->second.empty())
     {
-        if (found) return;
+        pool->misses++;
+        return std::nullopt;
+    }
+
+    pool->hits++;
+    std::optional<Script::Instance> instance(std::move(it->second.back()));
+    it->second.pop_back();
+    return instance;
+}
+
+void loadScript(const std::string& filename, flecs::world& world, flecs::entity entity, Script& script)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    const EntityHandle self = { world.c_ptr(), entity.raw_id() };
+
+    // Shared runtimes know their path without touching the filesystem
+    auto shared = (Script::Shared ? sharedRuntime(filename, world) : nullptr);
+    const auto path = (shared ? shared->path() : std::filesystem::weakly_canonical(filename)).string();
+
+    // A recycled script has already been reset, it only needs to know who it belongs to now
+    if (auto pooled = pooledScript(path, world))
+    {
+        pooled->runtime->setGlobal(pooled->env, "self", self);
+        script.runtime.push_back(std::move(pooled.value()));
+    }
+    else if (shared)
+    {
+        // Load the file once per world, every entity after that only runs the chunk in a new environment
+        auto runtime = std::move(shared);
+        auto instance = runtime->createInstance();
+        if (!instance)
+        {
+            Log::Logger::instance("engine")->error("Error running \"{}\": {}", filename, instance.error().message());
+            return;
+        }
+
+        runtime->setGlobal(instance.value(), "self", self);
+        script.runtime.emplace_back(runtime, instance.value());
+    }
+    else
+    {
+        std::shared_ptr<Lua::Runtime> runtime = loadRuntime(filename, world);
+        runtime->setGlobal(Lua::Runtime::Instance::Global, "self", self);
+        script.runtime.emplace_back(std::move(runtime), Lua::Runtime::Instance::Global);
+    }
+
+    Script::SpawnTime += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count() / 1e3;
+    Script::SpawnCount++;
+}
+
+// Scripts added during the parallel phase, the workers append to it concurrently
+static std::mutex deferred_mutex;
+static std::vector<std::tuple<flecs::world_t*, flecs::entity_t, std::string>> deferred_scripts;
+
+void deferScript(flecs::world_t* world, flecs::entity_t entity, const std::string& filename)
+{
+    std::scoped_lock lock(deferred_mutex);
+    deferred_scripts.emplace_back(world, entity, filename);
+}
+
+void loadDeferredScripts(flecs::world& world)
+{
+    decltype(deferred_scripts) scripts;
+    {
+        std::scoped_lock lock(deferred_mutex);
+        if (deferred_scripts.empty()) return;
+
+        // Leave the ones for other worlds where they are
+        auto it = std::stable_partition(deferred_scripts.begin(), deferred_scripts.end(),
+            [&](const auto& script) { return std::get<0>(script) != world.c_ptr(); });
+        scripts.assign(std::make_move_iterator(it), std::make_move_iterator(deferred_scripts.end()));
+        deferred_scripts.erase(it, deferred_scripts.end());
+    }
+
+    for (const auto& [w, id, filename] : scripts)
+    {
+        flecs::entity entity(world, id);
+        if (!entity.is_alive()) continue;
+
+        if (!entity.has<Script>()) entity.set<Script>({});
+        loadScript(filename, world, entity, *entity.get_mut<Script>());
+    }
+}
+
+void recycleScript(const WorldHandle& world_handle, flecs::entity entity, Script& script)
+{
+    if (!ScriptPool::Enabled || script.runtime.empty()) return;
+
+    auto world = flecs::world(world_handle.world);
+    if (!world.has<ScriptPool>()) world.set<ScriptPool>({});
+    auto* pool = world.get_mut<ScriptPool>();
+
+    const EntityHandle entity_handle = { world_handle.world, entity.raw_id() };
+    for (auto& instance : script.runtime)
+    {
+        if (!instance.runtime || !instance.runtime->good()) continue;
+
+        auto& free = pool->free[instance.runtime->path().string()];
+        if (free.size() >= ScriptPool::Capacity) 
+        {
+            pool->dropped++;
+            continue;
+        }
+
+        // Let the script put itself back in order, otherwise start it over from the top
+        const auto reset = [&]() -> Lua::Runtime::Result<void>
+        {
+            if (!instance.runtime->hasFunction((uint32_t)ScriptFunction::Reset, instance.env))
+                return instance.runtime->resetInstance(instance.env);
+
+            const auto ret = instance.runtime->runFunction<>(instance.env, (uint32_t)ScriptFunction::Reset, world_handle, entity_handle);
+            if (!ret) return { { ret.error().code(), ret.error().message() } };
+            return { };
+        }();
+
+        if (!reset)
+        {
+            Log::Logger::instance("engine")->error("Error resetting \"{}\" for reuse: {}", instance.runtime->filename(), reset.error().message());
+            pool->dropped++;
+            continue;
+        }
+
+        instance.started = false;
+        free.push_back(std::move(instance));
+        pool->recycled++;
+    }
+
+    script.runtime.clear();
+}
+
+void loadSystem(const std::string& filename, flecs::world& world)
+{
+    auto& log = Log::Logger::instance("engine");
+
+    auto runtime  = sharedRuntime(filename, world);
+    auto instance = runtime->createInstance();
+    if (!instance)
+    {
+        log->error("Error running \"{}\": {}", filename, instance.error().message());
+        return;
+    }
+
+    Script::Instance script(runtime, instance.value());
+    if (!runtime->hasFunction((uint32_t)ScriptFunction::System, script.env))
+    {
+        log->error("System \"{}\" has no System function", filename);
+        return;
+    }
+
+    auto query = runtime->getGlobal<Lua::Table>(script.env, "Query");
+    if (!query)
+    {
+        log->error("System \"{}\" has no Query table", filename);
+        return;
+    }
 
-        const std::size_t i = n;
-        const auto actual_id = world.component<ComponentData<(Name)i>>().raw_id();
-        if (actual_id == component_id)
+    std::vector<flecs::id_t>  components;
+    std::vector<const Field*> layouts;
+    auto builder = world.query_builder<>();
+    for (uint32_t i = 1; i <= query.value().size(); i++)
+    {
+        const auto id = (flecs::id_t)query.value().get<Lua::Number>(i);
+        const auto* layout = getComponentLayout(id, world);
+        if (!layout)
         {
-            found = true;
-            Component<(Name)i>::fromTable(table, _data);
+            log->error("System \"{}\" queries an unknown component ({})", filename, id);
+            return;
         }
+
+        // Only components the entity owns, one inherited from a prefab would be a single shared element
+        builder.term(id).self();
+        components.push_back(id);
+        layouts.push_back(layout);
+    }
+
+    if (!world.has<LuaSystems>()) world.set<LuaSystems>({});
+    world.get_mut<LuaSystems>()->systems.push_back(LuaSystem{
+        std::move(script),
+        builder.build(),
+        std::move(components),
+        std::move(layouts)
     });
-    
-    S2D_ASSERT(found, "Component doesn't exist");
+}
+
+/* struct ComponentTable */
+void ComponentTable::add(flecs::id_t id, const ComponentInfo& info)
+{
+    const auto index = (uint32_t)infos.size();
+    infos.push_back(info);
+
+    if (id < DenseLimit)
+    {
+        if (id >= dense.size()) dense.resize(id + 1, -1);
+        dense[id] = (int32_t)index;
+    }
+    else sparse[id] = index;
+}
+
+const ComponentInfo* ComponentTable::find(flecs::id_t id) const
+{
+    if (id < dense.size()) return (dense[id] >= 0 ? &infos[dense[id]] : nullptr);
+    if (id < DenseLimit) return nullptr;
+
+    const auto it = sparse.find(id);
+    return (it != sparse.end() ? &infos[it->second] : nullptr);
+}
+
+template<Name N>
+static ComponentInfo
+engineComponentInfo()
+{
+    using Data = ComponentData<N>;
+
+    ComponentInfo info;
+    info.name   = *N;
+    info.size   = sizeof(Data);
+    info.layout = &Component<N>::getLayout();
+
+    info.getTable = [](const void* data) { return Component<N>::getTable(*static_cast<const Data*>(data)); };
+    info.push     = [](Lua::State L, const void* data) { Component<N>::getTable(*static_cast<const Data*>(data)).toStack(L); };
+
+    info.fromTable = [](const Lua::Table& table, void* data)     { Component<N>::fromTable(table, data); };
+    info.fromView  = [](const Lua::TableView& table, void* data) { Component<N>::fromTable(table, data); };
+
+    info.emplace = [](flecs::entity entity, const Lua::TableView* table)
+    {
+        Data data{};
+        if (table) Component<N>::fromTable(*table, (void*)&data);
+        entity.set(data);
+    };
+
+    return info;
+}
+
+const ComponentTable&
+componentTable(flecs::world_t* world_ptr)
+{
+    flecs::world world(world_ptr);
+    if (!world.has<ComponentTable>())
+    {
+        ComponentTable table;
+        Util::CompileTime::static_for<(int)Name::Count>([&](auto n)
+        {
+            constexpr std::size_t i = n;
+            constexpr auto component = static_cast<Name>(i);
+            table.add(world.component<ComponentData<component>>().raw_id(), engineComponentInfo<component>());
+        });
+        world.set<ComponentTable>(std::move(table));
+    }
+    return *world.get<ComponentTable>();
+}
+
+void
+registerComponent(flecs::world_t* world_ptr, flecs::id_t id, const ComponentInfo& info)
+{
+    componentTable(world_ptr);
+    flecs::world(world_ptr).get_mut<ComponentTable>()->add(id, info);
+}
+
+const Field*
+getComponentLayout(
+    flecs::id_t component_id,
+    flecs::world& world)
+{
+    const auto* info = componentTable(world.c_ptr()).find(component_id);
+    return (info ? info->layout : nullptr);
+}
+
+void
+setComponentFromTable(
+    const Lua::Table& table, 
+    void* _data, 
+    flecs::id_t component_id, 
+    flecs::world& world)
+{
+    const auto* info = componentTable(world.c_ptr()).find(component_id);
+    S2D_ASSERT(info, "Component doesn't exist");
+    info->fromTable(table, _data);
 }
 
 /* Position */
@@ -102,19 +566,31 @@ Component<Name::Transform>::getTable(
     return table;
 }
 
+template<typename TableType>
 void
 Component<Name::Transform>::fromTable(
-    const Lua::Table& table,
+    const TableType& table,
     void* _data)
 {
     auto* data = reinterpret_cast<Data*>(_data);
 
-    const auto& position = table.get<Lua::Table>("position");
-    data->position.x = position.get<float>("x");
-    data->position.y = position.get<float>("y");
-    data->position.z = position.get<float>("z");
-    data->rotation = table.get<Lua::Number>("rotation");
-    data->scale = table.get<Lua::Number>("scale");
+    const auto& position = table.template get<Lua::Table>("position");
+    data->position.x = position.template get<float>("x");
+    data->position.y = position.template get<float>("y");
+    data->position.z = position.template get<float>("z");
+    data->rotation = table.template get<Lua::Number>("rotation");
+    data->scale = table.template get<Lua::Number>("scale");
+}
+
+const Field&
+Component<Name::Transform>::getLayout()
+{
+    static const Field layout = { "Transform", 0, Field::Type::Struct, {
+        { "position", offsetof(Data, position), Field::Type::Struct, positionFields<S2D::Math::Vec3f>(Field::Type::Number) },
+        { "rotation", offsetof(Data, rotation), Field::Type::Number },
+        { "scale",    offsetof(Data, scale),    Field::Type::Number }
+    }};
+    return layout;
 }
 
 S2D::Math::Transform modelTransform(const Transform* transform)
@@ -126,6 +602,28 @@ S2D::Math::Transform modelTransform(const Transform* transform)
     return model;
 }
 
+Transform interpolatedTransform(flecs::entity entity)
+{
+    const auto* transform = entity.get<Transform>();
+    S2D_ASSERT(transform, "Entity missing transform");
+
+    const auto* previous = entity.get<PreviousTransform>();
+    if (!previous) return *transform;
+
+    const auto t = (float)Time::interpolation;
+
+    // The short way round
+    auto rotation = transform->rotation - previous->rotation;
+    if (rotation >  180.f) rotation -= 360.f;
+    if (rotation < -180.f) rotation += 360.f;
+
+    Transform blended;
+    blended.position = previous->position + (transform->position - previous->position) * t;
+    blended.scale    = previous->scale + (transform->scale - previous->scale) * t;
+    blended.rotation = previous->rotation + rotation * t;
+    return blended;
+}
+
 /* Rigidbody */
 Lua::Table 
 Component<Name::Rigidbody>::getTable(
@@ -149,23 +647,35 @@ Component<Name::Rigidbody>::getTable(
     return table;
 }
 
+template<typename TableType>
 void
 Component<Name::Rigidbody>::fromTable(
-    const Lua::Table& table,
+    const TableType& table,
     void* _data)
 {
     auto* data = reinterpret_cast<Data*>(_data);
-    const auto& velocity = table.get<Lua::Table>("velocity");
-    data->velocity.x = velocity.get<float>("x");
-    data->velocity.y = velocity.get<float>("y");
-    data->velocity.z = velocity.get<float>("z");
+    const auto& velocity = table.template get<Lua::Table>("velocity");
+    data->velocity.x = velocity.template get<float>("x");
+    data->velocity.y = velocity.template get<float>("y");
+    data->velocity.z = velocity.template get<float>("z");
+
+    const auto& added_force = table.template get<Lua::Table>("addedForce");
+    data->added_force.x = added_force.template get<Lua::Number>("x");
+    data->added_force.y = added_force.template get<Lua::Number>("y");
+    data->added_force.z = added_force.template get<Lua::Number>("z");
 
-    const auto& added_force = table.get<Lua::Table>("addedForce");
-    data->added_force.x = added_force.get<Lua::Number>("x");
-    data->added_force.y = added_force.get<Lua::Number>("y");
-    data->added_force.z = added_force.get<Lua::Number>("z");
+    data->linear_drag = table.template get<Lua::Number>("linearDrag");
+}
 
-    data->linear_drag = table.get<Lua::Number>("linearDrag");
+const Field&
+Component<Name::Rigidbody>::getLayout()
+{
+    static const Field layout = { "Rigidbody", 0, Field::Type::Struct, {
+        { "velocity",   offsetof(Data, velocity),    Field::Type::Struct, positionFields<S2D::Math::Vec3f>(Field::Type::Number) },
+        { "addedForce", offsetof(Data, added_force), Field::Type::Struct, positionFields<S2D::Math::Vec3f>(Field::Type::Number) },
+        { "linearDrag", offsetof(Data, linear_drag), Field::Type::Number }
+    }};
+    return layout;
 }
 
 Lua::Table 
@@ -183,16 +693,27 @@ Component<Name::Sprite>::getTable(
     return table;
 }
 
+template<typename TableType>
 void 
 Component<Name::Sprite>::fromTable(
-    const Lua::Table& table, 
+    const TableType& table, 
     void* _data)
 {
     auto* data = reinterpret_cast<Data*>(_data);
-    const auto& size = table.get<Lua::Table>("size");
-    data->size.x = size.get<Lua::Number>("width");
-    data->size.y = size.get<Lua::Number>("height");
-    data->texture = table.get<Lua::String>("texture");
+    const auto& size = table.template get<Lua::Table>("size");
+    data->size.x = size.template get<Lua::Number>("width");
+    data->size.y = size.template get<Lua::Number>("height");
+    data->texture = table.template get<Lua::String>("texture");
+}
+
+const Field&
+Component<Name::Sprite>::getLayout()
+{
+    static const Field layout = { "Sprite", 0, Field::Type::Struct, {
+        { "size",    offsetof(Data, size),    Field::Type::Struct, sizeFields<S2D::Math::Vec2f>(Field::Type::Number) },
+        { "texture", offsetof(Data, texture), Field::Type::String }
+    }};
+    return layout;
 }
 
 Lua::Table 
@@ -207,16 +728,81 @@ Component<Name::Text>::getTable(
     return table;
 }
 
+template<typename TableType>
 void 
 Component<Name::Text>::fromTable(
-    const Lua::Table& table, 
+    const TableType& table, 
     void* _data)
 {
     auto* data = reinterpret_cast<Data*>(_data);
-    data->string = table.get<Lua::String>("string");
-    data->font   = table.get<Lua::String>("font");
-    data->character_size = table.get<Lua::Number>("characterSize");
-    data->align = (TextAlign)(int)table.get<Lua::Number>("textAlign");
+    data->string = table.template get<Lua::String>("string");
+    data->font   = table.template get<Lua::String>("font");
+    data->character_size = table.template get<Lua::Number>("characterSize");
+    data->align = (TextAlign)(int)table.template get<Lua::Number>("textAlign");
+}
+
+const Field&
+Component<Name::Text>::getLayout()
+{
+    static const Field layout = { "Text", 0, Field::Type::Struct, {
+        { "string",        offsetof(Data, string),         Field::Type::String },
+        { "font",          offsetof(Data, font),           Field::Type::String },
+        { "characterSize", offsetof(Data, character_size), Field::Type::Number },
+        { "textAlign",     offsetof(Data, align),          Field::Type::Enum   }
+    }};
+    return layout;
+}
+
+// Chunk holding a tile and the tile's index in it
+static uint32_t chunkOf(int32_t tile_x, int32_t tile_y, uint32_t& index)
+{
+    using SolidGrid = Component<Name::Tilemap>::SolidGrid;
+    const int32_t chunk_x = tile_x >> SolidGrid::ChunkShift;
+    const int32_t chunk_y = tile_y >> SolidGrid::ChunkShift;
+    index = (uint32_t)((tile_y & (SolidGrid::ChunkSize - 1)) * SolidGrid::ChunkSize + (tile_x & (SolidGrid::ChunkSize - 1)));
+    return ((uint32_t)(uint16_t)chunk_x << 16) | (uint16_t)chunk_y;
+}
+
+bool
+Component<Name::Tilemap>::SolidGrid::solid(
+    int32_t tile_x,
+    int32_t tile_y) const
+{
+    uint32_t index;
+    const auto it = chunks.find(chunkOf(tile_x, tile_y, index));
+    return it != chunks.end() && it->second[index] > 0;
+}
+
+void
+Component<Name::Tilemap>::SolidGrid::add(
+    int32_t tile_x,
+    int32_t tile_y,
+    int32_t count)
+{
+    uint32_t index;
+    const auto chunk = chunkOf(tile_x, tile_y, index);
+    if (count <= 0 && !chunks.count(chunk)) return;
+
+    auto& cell = chunks[chunk][index];
+    cell = (uint8_t)std::clamp<int32_t>(cell + count, 0, 255);
+}
+
+int32_t
+Component<Name::Tilemap>::Map::key(
+    int16_t x,
+    int16_t y)
+{
+    return (int32_t)(((uint32_t)(uint16_t)x << 16) | (uint16_t)y);
+}
+
+void
+Component<Name::Tilemap>::Map::coords(
+    int32_t key,
+    int16_t& x,
+    int16_t& y)
+{
+    x = (int16_t)((uint32_t)key >> 16);
+    y = (int16_t)((uint32_t)key & 0xFFFF);
 }
 
 void 
@@ -228,9 +814,13 @@ Component<Name::Tilemap>::Map::setTile(
 {
     if (!map.count(layer)) map.insert(std::pair(layer, std::pair(std::unordered_map<int32_t, Tile>(), LayerState::NotSolid)));
     auto& L = map.at(layer).first;
-    int32_t key = (x << 16) | y;
-    if (L.count(key)) L.at(key) = tile;
-    else L.insert(std::pair(key, tile));
+    const int32_t k = key(x, y);
+    if (L.count(k)) L.at(k) = tile;
+    else
+    {
+        L.insert(std::pair(k, tile));
+        if (map.at(layer).second == LayerState::Solid) solid.add(x, y, 1);
+    }
     changed = true;
 }
 
@@ -241,7 +831,16 @@ Component<Name::Tilemap>::Map::setLayerState(
 {
     if (!map.count(layer)) map.insert(std::pair(layer, std::pair(std::unordered_map<int32_t, Tile>(), state)));
     auto& L = map.at(layer);
-    if (L.second != state) L.second = state;
+    if (L.second != state)
+    {
+        L.second = state;
+        for (const auto& t : L.first)
+        {
+            int16_t x, y;
+            coords(t.first, x, y);
+            solid.add(x, y, (state == LayerState::Solid ? 1 : -1));
+        }
+    }
     changed = true;
 }
 
@@ -250,7 +849,7 @@ Component<Name::Tilemap>::setTile(
     Lua::State L)
 {
     const auto [ component_table, layer, x, y, cx, cy ] = 
-        Lua::Lib::Base::extractArgs<Lua::Table, Lua::Number, Lua::Number, Lua::Number, Lua::Number, Lua::Number>(L);
+        Lua::Lib::Base::viewArgs<Lua::Table, Lua::Number, Lua::Number, Lua::Number, Lua::Number, Lua::Number>(L);
 
     auto [ world, entity ] = Entity::extractWorldInfo(component_table);
 
@@ -272,7 +871,7 @@ Component<Name::Tilemap>::setLayerState(
     Lua::State L)
 {
     const auto [ component_table, layer, layer_state ] = 
-        Lua::Lib::Base::extractArgs<Lua::Table, Lua::Number, Lua::Number>(L);
+        Lua::Lib::Base::viewArgs<Lua::Table, Lua::Number, Lua::Number>(L);
 
     auto [ world, entity ] = Entity::extractWorldInfo(component_table);
 
@@ -310,18 +909,29 @@ Component<Name::Tilemap>::getTable(
     return table;
 }
 
+template<typename TableType>
 void 
 Component<Name::Tilemap>::fromTable(
-    const Lua::Table& table, 
+    const TableType& table, 
     void* _data)
 {
     auto* data = reinterpret_cast<Data*>(_data);
-    const auto& tilesize = table.get<Lua::Table>("tilesize");
-    data->tilesize.x = tilesize.get<Lua::Number>("width");
-    data->tilesize.y = tilesize.get<Lua::Number>("height");
+    const auto& tilesize = table.template get<Lua::Table>("tilesize");
+    data->tilesize.x = tilesize.template get<Lua::Number>("width");
+    data->tilesize.y = tilesize.template get<Lua::Number>("height");
+
+    const auto& spritesheet = table.template get<Lua::Table>("spritesheet");
+    data->spritesheet.texture_name = spritesheet.template get<Lua::String>("texture_name");
+}
 
-    const auto& spritesheet = table.get<Lua::Table>("spritesheet");
-    data->spritesheet.texture_name = spritesheet.get<Lua::String>("texture_name");
+const Field&
+Component<Name::Tilemap>::getLayout()
+{
+    // The tiles themselves are edited through setTile
+    static const Field layout = { "Tilemap", 0, Field::Type::Struct, {
+        { "tilesize", offsetof(Data, tilesize), Field::Type::Struct, sizeFields<S2D::Math::Vec2f>(Field::Type::Number) }
+    }};
+    return layout;
 }
 
 Lua::Table 
@@ -330,16 +940,69 @@ Component<Name::Collider>::getTable(
 {
     Lua::Table table;
     table.set<Lua::Number>("ColliderComponent", data.collider_component);
+    table.set<Lua::Boolean>("Static", data.is_static);
+    table.set("Shape", (Lua::Number)(int)data.shape);
+
+    Lua::Table size;
+    size.set("width",  data.size.x);
+    size.set("height", data.size.y);
+    table.set("Size", size);
+    table.set("Radius", data.radius);
+
+    Lua::Table points;
+    for (const auto& point : data.points)
+    {
+        Lua::Table p;
+        p.set("x", point.x);
+        p.set("y", point.y);
+        points.push(p);
+    }
+    table.set("Points", points);
     return table;
 }
 
+template<typename TableType>
 void 
 Component<Name::Collider>::fromTable(
-    const Lua::Table& table, 
+    const TableType& table, 
     void* _data)
 {
     auto* data = reinterpret_cast<Data*>(_data);
-    data->collider_component = table.get<Lua::Number>("ColliderComponent");
+    data->collider_component = table.template get<Lua::Number>("ColliderComponent");
+    if (table.hasValue("Static")) data->is_static = table.template get<Lua::Boolean>("Static");
+    if (table.hasValue("Shape"))  data->shape = (ColliderShape)(int)table.template get<Lua::Number>("Shape");
+    if (table.hasValue("Radius")) data->radius = table.template get<Lua::Number>("Radius");
+
+    if (table.hasValue("Size"))
+    {
+        const auto& size = table.template get<Lua::Table>("Size");
+        data->size.x = size.template get<Lua::Number>("width");
+        data->size.y = size.template get<Lua::Number>("height");
+    }
+
+    if (table.hasValue("Points"))
+    {
+        const auto& points = table.template get<Lua::Table>("Points");
+        data->points.clear();
+        for (uint32_t i = 1; i <= points.size(); i++)
+        {
+            const auto& point = points.template get<Lua::Table>(i);
+            data->points.push_back({ point.template get<Lua::Number>("x"), point.template get<Lua::Number>("y") });
+        }
+    }
+}
+
+const Field&
+Component<Name::Collider>::getLayout()
+{
+    static const Field layout = { "Collider", 0, Field::Type::Struct, {
+        { "ColliderComponent", offsetof(Data, collider_component), Field::Type::Number },
+        { "Static",            offsetof(Data, is_static),          Field::Type::Boolean },
+        { "Shape",             offsetof(Data, shape),              Field::Type::Enum    },
+        { "Size",              offsetof(Data, size),               Field::Type::Struct, sizeFields<S2D::Math::Vec2f>(Field::Type::Number) },
+        { "Radius",            offsetof(Data, radius),             Field::Type::Number  }
+    }};
+    return layout;
 }
 
 const char* operator*(Projection p)
@@ -356,11 +1019,11 @@ S2D::Math::Mat4f
 viewMatrix(
     flecs::entity camera)
 {
-    const auto camera_transform = camera.get<Transform>();
-    S2D_ASSERT(camera_transform, "Camera missing transform component");
+    S2D_ASSERT(camera.has<Transform>(), "Camera missing transform component");
+    const auto camera_transform = interpolatedTransform(camera);
 
     S2D::Math::Transform view;
-    view.translate(camera_transform->position * -1.f);
+    view.translate(camera_transform.position * -1.f);
     return view.matrix();
 }
 
@@ -403,18 +1066,30 @@ Component<Name::Camera>::getTable(
     return table;
 }
 
+template<typename TableType>
 void 
 Component<Name::Camera>::fromTable(
-    const Lua::Table& table, 
+    const TableType& table, 
     void* _data)
 {
     auto* data = reinterpret_cast<Data*>(_data);
-    data->FOV = table.get<Lua::Number>("FOV");
-    data->projection = (Projection)(int)table.get<Lua::Number>("projection");
+    data->FOV = table.template get<Lua::Number>("FOV");
+    data->projection = (Projection)(int)table.template get<Lua::Number>("projection");
 
-    const auto& size = table.get<Lua::Table>("size");
-    data->size.x = size.get<Lua::Number>("width");
-    data->size.y = size.get<Lua::Number>("height");
+    const auto& size = table.template get<Lua::Table>("size");
+    data->size.x = size.template get<Lua::Number>("width");
+    data->size.y = size.template get<Lua::Number>("height");
+}
+
+const Field&
+Component<Name::Camera>::getLayout()
+{
+    static const Field layout = { "Camera", 0, Field::Type::Struct, {
+        { "FOV",        offsetof(Data, FOV),        Field::Type::Number },
+        { "projection", offsetof(Data, projection), Field::Type::Enum   },
+        { "size",       offsetof(Data, size),       Field::Type::Struct, sizeFields<S2D::Math::Vec2u>(Field::Type::Unsigned) }
+    }};
+    return layout;
 }
 
 Lua::Table 
@@ -425,14 +1100,23 @@ Component<Name::CustomMesh>::getTable(
     return table;
 }
 
+template<typename TableType>
 void 
 Component<Name::CustomMesh>::fromTable(
-    const Lua::Table& table, 
+    const TableType& table, 
     void* _data)
 {
     auto* data = reinterpret_cast<Data*>(_data);
 }
 
+const Field&
+Component<Name::CustomMesh>::getLayout()
+{
+    // The mesh is edited through the Mesh library
+    static const Field layout = { "CustomMesh", 0, Field::Type::Struct };
+    return layout;
+}
+
 Lua::Table 
 Component<Name::Shader>::getTable(
     const Data& data)
@@ -442,15 +1126,42 @@ Component<Name::Shader>::getTable(
     return table;
 }
 
+template<typename TableType>
 void 
 Component<Name::Shader>::fromTable(
-    const Lua::Table& table, 
+    const TableType& table, 
     void* _data)
 {
     auto* data = reinterpret_cast<Data*>(_data);
-    data->name = table.get<Lua::String>("name");
+    data->name = table.template get<Lua::String>("name");
 }
 
+const Field&
+Component<Name::Shader>::getLayout()
+{
+    static const Field layout = { "Shader", 0, Field::Type::Struct, {
+        { "name", offsetof(Data, name), Field::Type::String }
+    }};
+    return layout;
+}
+
+// Components are read from owned tables (scenes) and from tables viewed on the stack (libraries)
+#define FROM_TABLE_INSTANCES(name)                                                      \
+    template void Component<Name::name>::fromTable(const Lua::Table&, void*);           \
+    template void Component<Name::name>::fromTable(const Lua::TableView&, void*);
+
+FROM_TABLE_INSTANCES(Transform)
+FROM_TABLE_INSTANCES(Rigidbody)
+FROM_TABLE_INSTANCES(Sprite)
+FROM_TABLE_INSTANCES(Text)
+FROM_TABLE_INSTANCES(Tilemap)
+FROM_TABLE_INSTANCES(Collider)
+FROM_TABLE_INSTANCES(Camera)
+FROM_TABLE_INSTANCES(CustomMesh)
+FROM_TABLE_INSTANCES(Shader)
+
+#undef FROM_TABLE_INSTANCES
+
 void
 registerComponents(Lua::Table& table, flecs::world& world)
 {
@@ -460,7 +1171,11 @@ registerComponents(Lua::Table& table, flecs::world& world)
         constexpr auto component = static_cast<Name>(i);
         using Data = ComponentData<component>;
         table.set(std::string(*component), (Lua::Number)world.component<Data>().raw_id());
-    });    
+    });
+
+    if (!world.has<ComponentSchemas>()) return;
+    for (const auto& schema : world.get<ComponentSchemas>()->schemas)
+        table.set(schema->name, (Lua::Number)schema->id);
 }
 
 }
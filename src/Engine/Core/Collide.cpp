@@ -1,68 +1,435 @@
 #include <Simple2D/Engine/Core.hpp>
+#include <Simple2D/Engine/Events.hpp>
 
 #include <Simple2D/Engine/LuaLib/Entity.hpp>
+#include <Simple2D/Engine/LuaLib/Time.hpp>
 #include <Simple2D/Engine/LuaLib/World.hpp>
 
 #include <Simple2D/Log/Log.hpp>
 
 #include "../Mesh/CollisionMesh.cpp"
 
+#include <cmath>
+
 namespace S2D::Engine
 {
 
+/**
+ * @brief The collision objects of a scene kept in a dynamic AABB tree between frames
+ *
+ * Each collider's object lives in its entity's CollisionProxy, made the first time the
+ * collider has a model (or right away for native shapes), and leaves the tree with the
+ * entity, its Collider or the Collider's model. Objects are only moved when flecs reports their table's Transform (or Collider)
+ * changed, static ones never are. Tilemaps stay out of the tree, bodies are laid over
+ * their solid grid instead.
+ */
+struct Broadphase
+{
+    fcl::DynamicAABBTreeCollisionManagerf manager;
+
+    // Scratch list of the proxies overlapping the one being tested
+    const fcl::CollisionObjectf* query = nullptr;
+    std::vector<fcl::CollisionObjectf*> candidates;
+
+    flecs::query<const Transform, const Collider> unbuilt;
+    flecs::query<const Transform, const Collider, const CollisionProxy> built;
+    flecs::query<const Collider, const CollisionProxy, Transform, Rigidbody> bodies;
+    flecs::query<const Transform, const Tilemap> tilemaps;
+    flecs::query<const CollisionProxy> orphaned; // Proxies whose entity lost its Collider
+};
+
+/**
+ * @brief What a CollisionProxy points to
+ *
+ * Native shapes are seen by fcl as the box around them, which is all the broadphase
+ * needs. Two native shapes are tested against each other with \ref collideShapes,
+ * a native shape against a mesh goes through fcl with that box.
+ */
+struct ProxyFCL
+{
+    std::unique_ptr<fcl::CollisionObjectf> object;
+    flecs::entity_t entity;
+
+    // What the object was made from, it is remade when any of it changes
+    const void* model = nullptr; // Mesh colliders
+    ColliderShape shape;
+    Math::Vec2f size;
+    float radius;
+    float scale;
+    std::vector<Math::Vec2f> points;
+    Math::Vec2f center; // Middle of the native shape around its origin, where the box sits
+
+    Math::Vec2f position;
+    float rotation;
+    Shape2D world; // The native shape where the Transform puts it
+
+    // The scene may be torn down before the world destroys its entities
+    std::weak_ptr<Broadphase> tree;
+
+    ~ProxyFCL()
+    {
+        if (auto broadphase = tree.lock()) broadphase->manager.unregisterObject(object.get());
+    }
+};
+
+static bool collectCandidate(fcl::CollisionObjectf* a, fcl::CollisionObjectf* b, void* data)
+{
+    auto* tree = reinterpret_cast<Broadphase*>(data);
+    tree->candidates.push_back(a == tree->query ? b : a);
+    return false;
+}
+
+static std::shared_ptr<CollisionFCL::Model> collisionModel(const Collider& collider)
+{
+    if (!collider.mesh || !collider.mesh->fcl_collision_data) return nullptr;
+    return reinterpret_cast<CollisionFCL*>(collider.mesh->fcl_collision_data.get())->model;
+}
+
+// A mesh collider can't have an object until its sprite or tilemap made the model
+static bool buildable(const Collider& collider)
+{
+    return collider.shape != ColliderShape::Mesh || collisionModel(collider);
+}
+
+// A box left at zero takes the size of the entity's sprite
+static Math::Vec2f colliderSize(flecs::entity entity, const Collider& collider)
+{
+    if (collider.shape != ColliderShape::Box || collider.size.x || collider.size.y || !entity.has<Sprite>())
+        return collider.size;
+    return entity.get<Sprite>()->size;
+}
+
+static bool matches(const ProxyFCL& proxy, flecs::entity entity, const Transform& transform, const Collider& collider)
+{
+    if (collider.shape != proxy.shape) return false;
+    if (collider.shape == ColliderShape::Mesh) return collisionModel(collider).get() == proxy.model;
+
+    const auto size = colliderSize(entity, collider);
+    if (size.x != proxy.size.x || size.y != proxy.size.y) return false;
+    if (collider.radius != proxy.radius || transform.scale != proxy.scale) return false;
+    if (collider.points.size() != proxy.points.size()) return false;
+    for (std::size_t i = 0; i < collider.points.size(); i++)
+        if (collider.points[i].x != proxy.points[i].x || collider.points[i].y != proxy.points[i].y) return false;
+    return true;
+}
+
+static Broadphase& broadphase(Scene* scene)
+{
+    if (!scene->broadphase)
+    {
+        auto broadphase = std::make_shared<Broadphase>();
+        broadphase->unbuilt = scene->world.query_builder<const Transform, const Collider>().without<CollisionProxy>().without<Tilemap>().build();
+        broadphase->built   = scene->world.query_builder<const Transform, const Collider, const CollisionProxy>().build();
+        broadphase->bodies  = scene->world.query_builder<const Collider, const CollisionProxy, Transform, Rigidbody>().build();
+        broadphase->tilemaps = scene->world.query_builder<const Transform, const Tilemap>().with<Collider>().build();
+        broadphase->orphaned = scene->world.query_builder<const CollisionProxy>().without<Collider>().build();
+        scene->broadphase = broadphase;
+    }
+    return *reinterpret_cast<Broadphase*>(scene->broadphase.get());
+}
+
+// Moves the object (and the native shape) to where the Transform is
+static void place(ProxyFCL& proxy, const Transform& transform)
+{
+    proxy.position = { transform.position.x, transform.position.y };
+    proxy.rotation = transform.rotation;
+
+    auto transform_matrix = fcl::Transform3f::Identity();
+    if (proxy.shape == ColliderShape::Mesh)
+    {
+        // Need to add rotation to this
+        transform_matrix.translation() = fcl::Vector3f(proxy.position.x, proxy.position.y, 0);
+    }
+    else
+    {
+        const float angle = proxy.rotation * 3.14159265f / 180.f;
+        const float c = std::cos(angle), s = std::sin(angle);
+        transform_matrix.linear() = fcl::AngleAxisf(angle, fcl::Vector3f::UnitZ()).toRotationMatrix();
+        transform_matrix.translation() = fcl::Vector3f(
+            proxy.position.x + proxy.center.x * c - proxy.center.y * s,
+            proxy.position.y + proxy.center.x * s + proxy.center.y * c,
+            0);
+        proxy.world = makeShape(proxy.shape, proxy.size, proxy.radius, proxy.points, proxy.position, proxy.rotation, proxy.scale);
+    }
+
+    proxy.object->setTransform(transform_matrix);
+    proxy.object->computeAABB();
+}
+
+static std::shared_ptr<void> makeProxy(Scene* scene, flecs::entity entity, const Transform& transform, const Collider& collider)
+{
+    auto tree  = std::static_pointer_cast<Broadphase>(scene->broadphase);
+    auto proxy = std::make_shared<ProxyFCL>();
+    proxy->entity = entity.raw_id();
+    proxy->shape  = collider.shape;
+    proxy->size   = colliderSize(entity, collider);
+    proxy->radius = collider.radius;
+    proxy->scale  = transform.scale;
+    proxy->points = collider.points;
+    proxy->tree   = tree;
+
+    std::shared_ptr<fcl::CollisionGeometryf> geometry;
+    if (collider.shape == ColliderShape::Mesh)
+    {
+        const auto model = collisionModel(collider);
+        proxy->model = model.get();
+        geometry = model;
+    }
+    else
+    {
+        const auto local = makeShape(proxy->shape, proxy->size, proxy->radius, proxy->points, {}, 0.f, proxy->scale);
+        const auto extent = local.max - local.min;
+        proxy->center = (local.min + local.max) * 0.5f;
+        geometry = std::make_shared<fcl::Boxf>(std::max(extent.x, 1e-3f), std::max(extent.y, 1e-3f), 1.f);
+    }
+
+    proxy->object = std::make_unique<fcl::CollisionObjectf>(geometry);
+    proxy->object->setUserData(proxy.get());
+    place(*proxy, transform);
+    tree->manager.registerObject(proxy->object.get());
+    return proxy;
+}
+
+/**
+ * @brief The solid tiles of a tilemap collider and where they are in the world
+ */
+struct TileGrid
+{
+    flecs::entity_t entity;
+    const Component<Name::Tilemap>::SolidGrid* solid;
+    Math::Vec2f origin; // Corner of tile (0, 0)
+    Math::Vec2f cell;   // Size of a tile
+
+    // Range of tiles under a box, inclusive
+    void range(const Math::Vec2f& min, const Math::Vec2f& max, int32_t& x0, int32_t& y0, int32_t& x1, int32_t& y1) const
+    {
+        x0 = (int32_t)std::floor((min.x - origin.x) / cell.x);
+        y0 = (int32_t)std::floor((min.y - origin.y) / cell.y);
+        x1 = (int32_t)std::floor((max.x - origin.x) / cell.x);
+        y1 = (int32_t)std::floor((max.y - origin.y) / cell.y);
+    }
+
+    Shape2D tile(int32_t x, int32_t y) const
+    {
+        const Math::Vec2f center(origin.x + (x + 0.5f) * cell.x, origin.y + (y + 0.5f) * cell.y);
+        return makeShape(ColliderShape::Box, cell, 0.f, {}, center, 0.f, 1.f);
+    }
+};
+
+static void translate(Shape2D& shape, const Math::Vec2f& offset)
+{
+    for (auto& point : shape.points) point += offset;
+    shape.min += offset;
+    shape.max += offset;
+}
+
+/**
+ * @brief Sweep a box through a tile grid
+ * @param grid     The tiles
+ * @param min      Lower corner of the box
+ * @param max      Upper corner of the box
+ * @param motion   How far the box moves
+ * @param fraction Set to how much of the motion happens before the box hits a tile
+ * @param normal   Set to the face of the tile it hits
+ * @return bool Whether it hits one, tiles the box already overlaps are left to the overlap test
+ */
+static bool sweepTiles(const TileGrid& grid, const Math::Vec2f& min, const Math::Vec2f& max, const Math::Vec2f& motion, float& fraction, Math::Vec2f& normal)
+{
+    int32_t x0, y0, x1, y1;
+    grid.range(
+        Math::Vec2f(std::min(min.x, min.x + motion.x), std::min(min.y, min.y + motion.y)),
+        Math::Vec2f(std::max(max.x, max.x + motion.x), std::max(max.y, max.y + motion.y)),
+        x0, y0, x1, y1);
+
+    // When the box starts and stops overlapping a span along one axis
+    const auto slab = [](float min, float max, float tile_min, float tile_max, float motion, float& entry, float& exit)
+    {
+        if (motion == 0.f)
+        {
+            entry = -std::numeric_limits<float>::max();
+            exit  =  std::numeric_limits<float>::max();
+            return max > tile_min && min < tile_max;
+        }
+        entry = ((motion > 0.f ? tile_min - max : tile_max - min)) / motion;
+        exit  = ((motion > 0.f ? tile_max - min : tile_min - max)) / motion;
+        return true;
+    };
+
+    bool hit = false;
+    fraction = 1.f;
+    for (int32_t y = y0; y <= y1; y++)
+        for (int32_t x = x0; x <= x1; x++)
+        {
+            if (!grid.solid->solid(x, y)) continue;
+
+            const Math::Vec2f tile_min(grid.origin.x + x * grid.cell.x, grid.origin.y + y * grid.cell.y);
+            const Math::Vec2f tile_max = tile_min + grid.cell;
+
+            float entry_x, exit_x, entry_y, exit_y;
+            if (!slab(min.x, max.x, tile_min.x, tile_max.x, motion.x, entry_x, exit_x)) continue;
+            if (!slab(min.y, max.y, tile_min.y, tile_max.y, motion.y, entry_y, exit_y)) continue;
+
+            const float entry = std::max(entry_x, entry_y);
+            const float exit  = std::min(exit_x, exit_y);
+            if (entry < 0.f || entry > exit || entry >= fraction) continue;
+
+            hit = true;
+            fraction = entry;
+            normal = (entry_x > entry_y ?
+                Math::Vec2f(motion.x > 0.f ? -1.f : 1.f, 0.f) :
+                Math::Vec2f(0.f, motion.y > 0.f ? -1.f : 1.f));
+        }
+    return hit;
+}
+
 void Core::collide(Scene* scene)
 {
     auto& logger = Log::Logger::instance("engine");
     auto& world = scene->world;
-    auto tilemap_filter = world.filter<const Transform, const Collider>(); 
+    auto& bus = eventBus(world);
+    auto& tree = broadphase(scene);
 
-    std::unordered_map<flecs::id_t, std::unique_ptr<fcl::CollisionObjectf>> map;
-    tilemap_filter.each(
+    // Proxies of entities that lost their Collider (or whose Collider lost its model) leave the tree with the component
+    std::vector<flecs::entity_t> dropped;
+    tree.orphaned.each([&](flecs::entity entity, const CollisionProxy&) { dropped.push_back(entity.raw_id()); });
+    for (const auto entity : dropped) world.entity(entity).remove<CollisionProxy>();
+    dropped.clear();
+
+    // Colliders that got a model since last frame get their proxy, added after the iteration
+    std::vector<std::pair<flecs::entity_t, std::shared_ptr<void>>> made;
+    tree.unbuilt.each(
         [&](
             flecs::entity    entity,
             const Transform& transform,
             const Collider&  collider)
         {
-            std::shared_ptr<CollisionFCL::Model> model;
-            if (collider.mesh) model = reinterpret_cast<CollisionFCL*>(collider.mesh->fcl_collision_data.get())->model;
+            if (buildable(collider)) made.emplace_back(entity.raw_id(), makeProxy(scene, entity, transform, collider));
+        });
+    if (made.size()) tree.manager.setup();
+
+    // Only the tables whose Transform or Collider changed are looked at
+    tree.built.iter(
+        [&](
+            flecs::iter&           it,
+            const Transform*       transforms,
+            const Collider*        colliders,
+            const CollisionProxy*  proxies)
+        {
+            if (!it.changed())
+            {
+                it.skip();
+                return;
+            }
 
-            if (!collider.mesh || (collider.mesh && model)) return;
+            for (auto i : it)
+            {
+                const auto& transform = transforms[it.is_self(1) ? i : 0];
+                const auto& collider  = colliders[it.is_self(2) ? i : 0];
+                auto* proxy = reinterpret_cast<ProxyFCL*>(proxies[i].object.get());
 
-            S2D_ASSERT(!map.count(entity.raw_id()), "Something went wrong");
+                if (!matches(*proxy, it.entity(i), transform, collider))
+                {
+                    if (!buildable(collider))
+                    {
+                        dropped.push_back(it.entity(i).raw_id());
+                        continue;
+                    }
+                    made.emplace_back(it.entity(i).raw_id(), makeProxy(scene, it.entity(i), transform, collider));
+                    continue;
+                }
+
+                const bool moved   = (transform.position.x != proxy->position.x || transform.position.y != proxy->position.y);
+                const bool rotated = (proxy->shape != ColliderShape::Mesh && transform.rotation != proxy->rotation);
+                if (collider.is_static || (!moved && !rotated)) continue;
 
-            // Need to add rotation to this
-            auto transform_matrix = fcl::Transform3f::Identity();
-            transform_matrix.translation() = fcl::Vector3f(transform.position.x, transform.position.y, 0);
-            map.insert(std::pair(
-                entity.raw_id(),
-                std::make_unique<fcl::CollisionObjectf>(model, transform_matrix)
-            ));
+                place(*proxy, transform);
+                tree.manager.update(proxy->object.get());
+            }
         });
 
-    scene->colliders.each(
+    // Setting the proxies outside the iterations, the old objects leave the tree as they're replaced
+    for (auto& [entity, proxy] : made) world.entity(entity).set<CollisionProxy>({ std::move(proxy) });
+    for (const auto entity : dropped) world.entity(entity).remove<CollisionProxy>();
+
+    std::vector<TileGrid> grids;
+    tree.tilemaps.each(
         [&](
-            flecs::entity    entity_a,
-            const Collider&  collider_a, 
-            /***/ Transform& transform_a,
-            /***/ Rigidbody& rigid_body_a)
+            flecs::entity    entity,
+            const Transform& transform,
+            const Tilemap&   tilemap)
         {
-            if (!map.count(entity_a.raw_id())) return;
-            auto& object_a = map.at(entity_a.raw_id());
+            if (!tilemap.tilesize.x || !tilemap.tilesize.y || tilemap.tiles.solid.chunks.empty()) return;
+
+            TileGrid grid;
+            grid.entity = entity.raw_id();
+            grid.solid  = &tilemap.tiles.solid;
+            grid.cell   = tilemap.tilesize * transform.scale;
+            grid.origin = Math::Vec2f(transform.position.x, transform.position.y) - grid.cell * 0.5f;
+            grids.push_back(grid);
+        });
 
-            tilemap_filter.each([&](
-                flecs::entity    entity_b,
-                const Transform& transform_b,
-                const Collider&  collider_b)
+    tree.bodies.each(
+        [&](
+            flecs::entity         entity_a,
+            const Collider&       collider_a,
+            const CollisionProxy& collision_proxy_a,
+            /***/ Transform&      transform_a,
+            /***/ Rigidbody&      rigid_body_a)
+        {
+            auto* proxy_a  = reinterpret_cast<ProxyFCL*>(collision_proxy_a.object.get());
+            auto* object_a = proxy_a->object.get();
+
+            // How far a has been pushed so far, its shape and object are where it was before
+            Math::Vec2f moved;
+
+            // dot is how far a moves out of b, correction how far it's actually pushed
+            const auto respond = [&](flecs::entity_t entity_b, const Math::Vec3f& dot, const Math::Vec3f& correction)
             {
-                if (entity_a == entity_b || !map.count(entity_b.raw_id())) return;
-                auto& object_b = map.at(entity_b.raw_id());
+                // Still not quite right... sometimes, it will invert the direction of the velocity as opposed to
+                // reflecting it... not quite sure *why* or *when* this happens.
+                const auto e_loss = 0.2f;
+                transform_a.position += Math::Vec3f(correction.x, correction.y, 0);
+                moved += Math::Vec2f(correction.x, correction.y);
+                rigid_body_a.velocity = (rigid_body_a.velocity - (dot.normalized() * rigid_body_a.velocity.dot(dot.normalized())) * 2.f) * e_loss;
+
+                // The scripts hear about it when the events are dispatched, not in the middle of the narrowphase
+                Event collision;
+                collision.type   = (uint32_t)EventType::Collision;
+                collision.source = entity_a.raw_id();
+                collision.target = entity_b;
+                collision.vector = { dot.x, dot.y };
+                collision.value  = dot.length();
+                bus.push(collision);
+            };
+
+            // Only the colliders whose boxes overlap this one reach the narrowphase
+            tree.query = object_a;
+            tree.candidates.clear();
+            tree.manager.collide(object_a, &tree, collectCandidate);
+
+            for (auto* object_b : tree.candidates)
+            {
+                if (object_b == object_a) continue;
+                const auto* proxy_b = reinterpret_cast<ProxyFCL*>(object_b->getUserData());
+
+                if (proxy_a->shape != ColliderShape::Mesh && proxy_b->shape != ColliderShape::Mesh)
+                {
+                    Manifold manifold;
+                    if (!collideShapes(proxy_b->world, proxy_a->world, manifold)) continue;
+
+                    // The manifold is exact, a is pushed just as far as it went into b
+                    const auto dot = Math::Vec3f(manifold.normal.x, manifold.normal.y, 0.f) * manifold.depth;
+                    if (dot.length() <= 1e-1) continue;
+                    respond(proxy_b->entity, dot, dot);
+                    continue;
+                }
 
                 fcl::CollisionRequest<float> request{0};
                 request.enable_contact = true;
                 request.num_max_contacts = std::numeric_limits<int>::max();
 
                 fcl::CollisionResult<float>  result;
-                fcl::collide(object_b.get(), object_a.get(), request, result);
+                fcl::collide(object_b, object_a, request, result);
 
                 if (result.isCollision())
                 {
@@ -89,42 +456,61 @@ void Core::collide(Scene* scene)
 
                     // World space and pixel space are the same, so we want to neglect any collisions that are less
                     // than a pixel deep, otherwise we get caught up on too much
-                    if (dot.length() <= 1e-1 || std::isnan(dot.x) || std::isnan(dot.y)) return;
-                    
-                    // Still not quite right... sometimes, it will invert the direction of the velocity as opposed to 
-                    // reflecting it... not quite sure *why* or *when* this happens.
-                    const auto e_loss = 0.2f;
-                    transform_a.position += Math::Vec3f(dot.x, dot.y, 0) * 1.5f;
-                    rigid_body_a.velocity = (rigid_body_a.velocity - (dot.normalized() * rigid_body_a.velocity.dot(dot.normalized())) * 2.f) * e_loss;
-
-                    if (entity_a.has<Script>())
+                    if (dot.length() <= 1e-1 || std::isnan(dot.x) || std::isnan(dot.y)) continue;
+                    respond(proxy_b->entity, dot, dot * 1.5f);
+                }
+            }
+
+            if (grids.empty()) return;
+
+            // The tiles are tested against a's shape, or the box around its mesh
+            Shape2D shape_a = proxy_a->world;
+            if (proxy_a->shape == ColliderShape::Mesh)
+            {
+                const auto& aabb = object_a->getAABB();
+                const Math::Vec2f min(aabb.min_[0], aabb.min_[1]), max(aabb.max_[0], aabb.max_[1]);
+                shape_a = makeShape(ColliderShape::Box, max - min, 0.f, {}, (min + max) * 0.5f, 0.f, 1.f);
+            }
+            translate(shape_a, moved);
+
+            for (const auto& grid : grids)
+            {
+                int32_t x0, y0, x1, y1;
+                grid.range(shape_a.min, shape_a.max, x0, y0, x1, y1);
+
+                for (int32_t y = y0; y <= y1; y++)
+                    for (int32_t x = x0; x <= x1; x++)
                     {
-                        auto* scripts = entity_a.get_mut<Script>();
-                        for (auto& script : scripts->runtime)
-                        {
-                            // Execute the update function
-                            auto ent = Engine::Entity().asTable();
-                            ent.set("entity", (void*)entity_a.raw_id());
-                            ent.set("good", true);
-                            ent.set("world", (void*)world.c_ptr()); // Currently hacky way to store a pointer (must be considered an int64)
-
-                            auto _world = Engine::World().asTable();
-                            _world.set("world", (void*)world.c_ptr());
-                            _world.set("good", true);
-
-                            Lua::Table collision;
-
-                            const auto res = script.first->runFunction<>("Collide", _world, ent, collision);
-                            if (!res && res.error().code() != Lua::Runtime::ErrorCode::NotFunction)
-                                Log::Logger::instance("engine")->error("Lua Collide(...) error ({}) in \"{}\": {}",
-                                    (int)res.error().code(),
-                                    script.first->filename(),
-                                    res.error().message());
-                        }
+                        if (!grid.solid->solid(x, y)) continue;
+
+                        Manifold manifold;
+                        if (!collideShapes(grid.tile(x, y), shape_a, manifold)) continue;
+
+                        // Pushing a out through a face shared with another solid tile snags it on the seam
+                        const auto& n = manifold.normal;
+                        if (std::abs(n.x) > 0.99f && grid.solid->solid(x + (n.x > 0.f ? 1 : -1), y)) continue;
+                        if (std::abs(n.y) > 0.99f && grid.solid->solid(x, y + (n.y > 0.f ? 1 : -1))) continue;
+
+                        const auto dot = Math::Vec3f(n.x, n.y, 0.f) * manifold.depth;
+                        if (dot.length() <= 1e-1) continue;
+                        respond(grid.entity, dot, dot);
+                        translate(shape_a, n * manifold.depth);
                     }
-                }
-            });
+
+                // A body crossing more than half its size in a step could skip over a wall, it stops at the first tile instead
+                const Math::Vec2f motion(rigid_body_a.velocity.x * (float)Time::dt, rigid_body_a.velocity.y * (float)Time::dt);
+                const auto extent = shape_a.max - shape_a.min;
+                if (std::abs(motion.x) <= extent.x * 0.5f && std::abs(motion.y) <= extent.y * 0.5f) continue;
+
+                float fraction;
+                Math::Vec2f normal;
+                if (!sweepTiles(grid, shape_a.min, shape_a.max, motion, fraction, normal)) continue;
+
+                if (normal.x) rigid_body_a.velocity.x *= fraction;
+                else          rigid_body_a.velocity.y *= fraction;
+            }
         });
+
 }
 
 }
@@ -4,12 +4,22 @@
 #include <Simple2D/Engine/LuaLib/Input.hpp>
 #include <Simple2D/Engine/LuaLib/Entity.hpp>
 #include <Simple2D/Engine/LuaLib/World.hpp>
+#include <Simple2D/Engine/LuaLib/System.hpp>
 #include <Simple2D/Engine/LuaLib/Time.hpp>
 
 #include <Simple2D/Engine/Application.hpp>
+#include <Simple2D/Engine/Commands.hpp>
+#include <Simple2D/Engine/Events.hpp>
+#include <Simple2D/Engine/Prefabs.hpp>
+#include <Simple2D/Engine/ThreadPool.hpp>
 
 #include <Simple2D/Log/Log.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <unordered_set>
+
 namespace S2D::Engine
 {
 
@@ -17,19 +27,22 @@ Scene::Scene() :
     scripts(
         world.query_builder<Script>().build()
     ),
-    colliders(
-        world.query_builder<const Collider, Transform, Rigidbody>().build()
-    ),
-    dead(
-        world.query_builder<Dead>().build()
-    ),
     rigidbodies(
         world.query_builder<Transform, Rigidbody>().build()
     ),
+    untracked(
+        world.query_builder<const Transform>().without<PreviousTransform>().build()
+    ),
+    tracked(
+        world.query_builder<const Transform, PreviousTransform>().build()
+    ),
     renderer(
         std::make_unique<Renderer>(this)
     )
 {
+    // The bindings look components up by ID, the table is built here so the lookups never register anything
+    componentTable(world.c_ptr());
+
     // Shaders should be in the renderer, and there should be different ones for each component type
     // Change the const shader pointer to a non-const and change the uniforms as needed there
     // load default shader
@@ -45,6 +58,83 @@ Scene* Core::getTopScene()
     return _scenes.top();
 }
 
+uint64_t Core::updateScripts(Scene* scene)
+{
+    auto& world = scene->world;
+    const WorldHandle world_handle = { world.c_ptr(), scene };
+
+    uint64_t calls = 0;
+    scene->scripts.each([&](flecs::entity e, Script& script)
+    {
+        if (!e.is_alive() || isDestroyQueued(world, e.raw_id())) return;
+        calls++;
+
+        // Execute the update function, the handles are cached inside each runtime
+        // so pushing them allocates nothing after the first frame
+        const EntityHandle entity_handle = { world.c_ptr(), e.raw_id() };
+
+        #define CHECK_FUNCTION(function)                                                                    \
+            if (instance.runtime->hasFunction((uint32_t)function, instance.env))                            \
+            {                                                                                               \
+                const auto ret = instance.runtime->template runFunction<>(instance.env, (uint32_t)function, world_handle, entity_handle); \
+                if (!ret)                                                                                   \
+                    Log::Logger::instance("engine")->error("Lua {}(...) error ({}) in \"{}\": {}",          \
+                        *function,                                                                          \
+                        (int)ret.error().code(),                                                            \
+                        instance.runtime->filename(),                                                       \
+                        ret.error().message());                                                             \
+            }
+
+        for (auto& instance : script.runtime)
+        {
+            S2D_ASSERT(instance.runtime, "Script runtime is null!");
+            if (!instance.started) 
+            { 
+                CHECK_FUNCTION(ScriptFunction::Start);
+                instance.started = true; 
+            }
+            CHECK_FUNCTION(ScriptFunction::Update);
+        }
+
+        #undef CHECK_FUNCTION
+
+        // Check if it has a collider component and execute the collision function
+    });
+    return calls;
+}
+
+uint64_t Core::runSystems(Scene* scene)
+{
+    auto& world = scene->world;
+    if (!world.has<LuaSystems>()) return 0;
+
+    const WorldHandle world_handle = { world.c_ptr(), scene };
+
+    uint64_t batches = 0;
+    for (auto& system : world.get_mut<LuaSystems>()->systems)
+    {
+        system.query.iter([&](flecs::iter& it)
+        {
+            const auto* iter = it.c_ptr();
+            uint64_t shared = 0;
+            for (int32_t term = 0; term < iter->field_count; term++)
+                if (!ecs_field_is_self(iter, term + 1)) shared |= (1ull << term);
+
+            const SystemIterHandle iter_handle = { world.c_ptr(), &system, iter->entities, iter->ptrs, iter->sizes, iter->count, shared, System::epoch };
+            batches++;
+
+            const auto ret = system.script.runtime->runFunction<>(system.script.env, (uint32_t)ScriptFunction::System, world_handle, iter_handle);
+            System::epoch++;
+            if (!ret)
+                Log::Logger::instance("engine")->error("Lua System(...) error ({}) in \"{}\": {}",
+                    (int)ret.error().code(),
+                    system.script.runtime->filename(),
+                    ret.error().message());
+        });
+    }
+    return batches;
+}
+
 void Core::run()
 {
     using namespace Graphics;
@@ -53,22 +143,29 @@ void Core::run()
 
     std::vector<double> frame_times(120);
 
+    // Time spent dispatching scripts and how many were run, reported with the frame times
+    double script_time = 0.0;
+    uint64_t script_calls = 0;
+
+    // Same for Lua systems, which are called once per matching table
+    double system_time = 0.0;
+    uint64_t system_batches = 0;
+
+    // Events delivered to scripts
+    uint64_t event_count = 0;
+
+    // Entities removed by the command buffer
+    uint64_t destroyed_count = 0;
+
+    // Simulation time not yet covered by a tick, and the ticks run or dropped
+    double accumulator = 0.0;
+    uint64_t tick_count = 0;
+    uint64_t dropped_ticks = 0;
+
     uint32_t frame = 0;
     while (window.isOpen() && _scenes.size())
     {
         Event event;
-
-        // Change all KeyState::Pressed to KeyState::Down
-        // Erase all KeyState::Released
-        std::vector<std::string> released;
-        for (auto& p : Input::global_state)
-        {
-            if (p.second == Input::KeyState::Press) p.second = Input::KeyState::Down;
-            if (p.second == Input::KeyState::Release) released.push_back(p.first);
-        }
-
-        for (const auto& c : released) Input::global_state.erase(c);
-
         while (window.pollEvent(event))
         {
             if (event.type == Event::Type::Close)
@@ -109,84 +206,109 @@ void Core::run()
         // We execute all the scripts
         // THEN the other registered systems run with world.progress()
         // THEN the draw method is called
+#   ifdef LUA_HOT_RELOAD
+        // Swap in any scripts or shaders that changed, between frames so nothing is mid-call
+        reload(top_scene);
+#   endif
+
         auto& world = top_scene->world;
         auto camera = world.filter<const Camera>().first();
 
-        top_scene->scripts.each([&](flecs::entity e, Script& script)
+        const WorldHandle world_handle = { world.c_ptr(), top_scene };
+
+        // The simulation runs in fixed ticks, as many as the time since the last frame covers
+        const double step = 1.0 / Time::tick_rate;
+        Time::dt = step;
+        accumulator += Time::frame_dt;
+
+        uint32_t substeps = 0;
+        while (accumulator >= step && substeps < Time::max_substeps)
         {
-            if (!e.is_alive() || e.has<Dead>()) return;
-
-            void* t = world.c_ptr();
-            // Execute the update function
-            auto ent = Engine::Entity().asTable();
-            ent.set("entity", (void*)e.raw_id());
-            ent.set("good", true);
-            ent.set("world", t); 
-
-            auto _world = Engine::World().asTable();
-            _world.superimpose(Engine::ResLib().asTable());
-            _world.set("world", (void*)world.c_ptr());
-            _world.set("scene", (void*)top_scene);
-            _world.set("good", true);
-
-            #define CHECK_FUNCTION(name) \
-                const auto ret = script.first->template runFunction<>(name, _world, ent);               \
-                if (!ret && ret.error().code() != Lua::Runtime::ErrorCode::NotFunction)                 \
-                    Log::Logger::instance("engine")->error("Lua Update(...) error ({}) in \"{}\": {}",  \
-                        (int)ret.error().code(),                                                        \
-                        script.first->filename(),                                                       \
-                        ret.error().message())                                                          
-
-            for (auto& script : script.runtime)
+            // Frames are drawn from where everything was at the start of the tick
+            std::vector<flecs::entity_t> untracked;
+            top_scene->untracked.each([&](flecs::entity e, const Transform&) { untracked.push_back(e.raw_id()); });
+            for (const auto e : untracked)
             {
-                S2D_ASSERT(script.first, "Script runtime is null!");
-                if (!script.second) 
-                { 
-                    CHECK_FUNCTION("Start");
-                    script.second = true; 
-                }
-                CHECK_FUNCTION("Update");
+                const auto* transform = world.entity(e).get<Transform>();
+                world.entity(e).set<PreviousTransform>({ transform->position, transform->scale, transform->rotation });
+            }
+            top_scene->tracked.each([](const Transform& transform, PreviousTransform& previous)
+            {
+                previous = { transform.position, transform.scale, transform.rotation };
+            });
+
+            const auto script_start = std::chrono::high_resolution_clock::now();
+            if (Script::Parallel)
+            {
+                // Workers are made the first time the phase runs, and again if the count changes
+                const uint32_t threads = (Script::Threads ? Script::Threads : std::max(std::thread::hardware_concurrency(), 1U));
+                if (!_workers || _workers->size() != threads) _workers = std::make_unique<ThreadPool>(threads);
+                script_calls += updateParallel(top_scene, *_workers);
+            }
+            else script_calls += updateScripts(top_scene);
+            script_time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - script_start).count() / 1e3;
+
+            // Lua systems get one call per matching table instead of one per entity
+            const auto system_start = std::chrono::high_resolution_clock::now();
+            system_batches += runSystems(top_scene);
+            system_time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - system_start).count() / 1e3;
+
+            // Change all KeyState::Pressed to KeyState::Down
+            // Erase all KeyState::Released
+            // The scripts have seen them once, a frame running no tick keeps them for the next one
+            std::vector<std::string> released;
+            for (auto& p : Input::global_state)
+            {
+                if (p.second == Input::KeyState::Press) p.second = Input::KeyState::Down;
+                if (p.second == Input::KeyState::Release) released.push_back(p.first);
             }
 
-            #undef CHECK_FUNCTION
+            for (const auto& c : released) Input::global_state.erase(c);
 
-            // Check if it has a collider component and execute the collision function
-        });
+            // Entities destroyed by the scripts, systems and last tick's collisions go here
+            destroyed_count += flushCommands(world_handle);
+
+            // Since colliders possibly change the velocity, we need to run collision check and *then* 
+            // do the rigidbody transformation
+            collide(top_scene);
+            top_scene->rigidbodies.each([&](Transform& transform, Rigidbody& rigidbody)
+            {
+                rigidbody.velocity += (rigidbody.added_force - rigidbody.velocity * rigidbody.linear_drag) * (float)Time::dt;
+                transform.position += Math::Vec3f(rigidbody.velocity.x, rigidbody.velocity.y, 0.f) * (float)Time::dt;
+            });
 
-        if (world.count<Dead>())
+            // Everything the tick emitted (collisions, destroyed entities, script events) is delivered here
+            event_count += dispatchEvents(world_handle);
+
+            accumulator -= step;
+            substeps++;
+            tick_count++;
+        }
+
+        // A frame too long to catch up on in max_substeps ticks slows the simulation down instead
+        if (accumulator >= step)
         {
-            std::vector<flecs::entity> dead_entities;
-            dead_entities.reserve(top_scene->dead.count());
-            top_scene->dead.each([&](flecs::entity e, Dead d)
-                { dead_entities.push_back(e); }
-            );
-            for (auto& e : dead_entities) e.destruct();
+            dropped_ticks += (uint64_t)(accumulator / step);
+            accumulator = std::fmod(accumulator, step);
         }
+        Time::interpolation = accumulator / step;
 
         window.clear();
 
         world.progress();
         top_scene->update();
 
+        // Everything is drawn Time::interpolation of the way from its previous tick, see interpolatedTransform
         render(top_scene);
-        
-        // Since colliders possibly change the velocity, we need to run collision check and *then* 
-        // do the rigidbody transformation
-        collide(top_scene);
-        top_scene->rigidbodies.each([&](Transform& transform, Rigidbody& rigidbody)
-        {
-            rigidbody.velocity += (rigidbody.added_force - rigidbody.velocity * rigidbody.linear_drag) * (float)Time::dt;
-            transform.position += Math::Vec3f(rigidbody.velocity.x, rigidbody.velocity.y, 0.f) * (float)Time::dt;
-        });
 
         window.display();
 
-        // Set dt
+        // Set the frame time
         auto now = std::chrono::high_resolution_clock::now();
-        Time::dt = std::chrono::duration_cast<std::chrono::microseconds>(now - tick).count() / 1e6;
-        if (Time::dt > 1.0) Time::dt = 1.0;
+        Time::frame_dt = std::chrono::duration_cast<std::chrono::microseconds>(now - tick).count() / 1e6;
+        if (Time::frame_dt > 1.0) Time::frame_dt = 1.0;
         tick = now;
-        frame_times[frame % frame_times.size()] = Time::dt;
+        frame_times[frame % frame_times.size()] = Time::frame_dt;
 
         // Set mouse position
         /*
@@ -215,6 +337,106 @@ void Core::run()
             for (const auto& time : frame_times) avg += time;
             avg /= (double)frame_times.size();
             Log::Logger::instance("engine")->trace("Last {} frames ran at {:0.1f} fps", frame_times.size(), 1.0 / avg);
+            Log::Logger::instance("engine")->trace("Ran {:0.2f} ticks per frame at {:0.1f} Hz ({} dropped)",
+                tick_count / (double)frame_times.size(),
+                Time::tick_rate,
+                dropped_ticks);
+            if (script_calls)
+                Log::Logger::instance("engine")->trace("Script dispatch took {:0.2f} us per entity ({} threads)", 
+                    script_time / (double)script_calls,
+                    (Script::Parallel && _workers ? _workers->size() : 1));
+
+            // Shared runtimes are only counted once
+            std::unordered_set<const Lua::Runtime*> runtimes;
+            std::size_t script_memory = 0;
+            uint64_t script_allocations = 0;
+
+            // The runtime holding the most memory is the first suspect for a leak
+            const Lua::Runtime* largest = nullptr;
+            Lua::Allocator::Stats largest_stats;
+            top_scene->scripts.each([&](Script& script)
+            {
+                for (const auto& instance : script.runtime)
+                {
+                    if (!runtimes.insert(instance.runtime.get()).second) continue;
+
+                    const auto stats = instance.runtime->memoryStats();
+                    script_memory      += stats.live;
+                    script_allocations += stats.allocations;
+                    if (!largest || stats.live > largest_stats.live)
+                    {
+                        largest       = instance.runtime.get();
+                        largest_stats = stats;
+                    }
+                }
+            });
+            if (runtimes.size())
+            {
+                Log::Logger::instance("engine")->trace("{} script runtimes ({}) using {:0.1f} KB over {} allocations, loading a script took {:0.2f} us",
+                    runtimes.size(),
+                    (Script::Shared ? "shared" : "per entity"),
+                    script_memory / 1024.0,
+                    script_allocations,
+                    (Script::SpawnCount ? Script::SpawnTime / (double)Script::SpawnCount : 0.0));
+                Log::Logger::instance("engine")->trace("Largest runtime \"{}\" holds {:0.1f} KB (peak {:0.1f} KB, {:0.1f} KB reserved)",
+                    largest->filename(),
+                    largest_stats.live / 1024.0,
+                    largest_stats.peak / 1024.0,
+                    largest_stats.reserved / 1024.0);
+            }
+            if (world.has<ScriptPool>())
+            {
+                const auto* pool = world.get<ScriptPool>();
+                if (pool->hits + pool->misses)
+                    Log::Logger::instance("engine")->trace("Script pool: {} hits, {} misses, {} recycled, {} dropped",
+                        pool->hits,
+                        pool->misses,
+                        pool->recycled,
+                        pool->dropped);
+            }
+
+            const auto chunks = Lua::ChunkCache::instance().stats();
+            if (chunks.misses)
+                Log::Logger::instance("engine")->trace("Script chunk cache: {} hits, {} from disk, {} parsed",
+                    chunks.hits,
+                    chunks.disk_hits,
+                    chunks.misses);
+            if (system_batches)
+                Log::Logger::instance("engine")->trace("Lua systems took {:0.2f} us per frame over {:0.1f} tables",
+                    system_time / (double)frame_times.size(),
+                    system_batches / (double)frame_times.size());
+            if (event_count && world.has<EventBus>())
+                Log::Logger::instance("engine")->trace("Delivered {:0.1f} events per frame ({} batched calls in total)",
+                    event_count / (double)frame_times.size(),
+                    world.get<EventBus>()->batches);
+            if (world.has<CommandBuffer>())
+            {
+                const auto* buffer = world.get<CommandBuffer>();
+                if (buffer->created + buffer->destroyed)
+                    Log::Logger::instance("engine")->trace("Command buffer: {:0.1f} destroyed per frame, {} created ({:0.2f} us each), {} destroyed ({:0.2f} us each over {} flushes)",
+                        destroyed_count / (double)frame_times.size(),
+                        buffer->created,
+                        (buffer->created ? buffer->create_time / (double)buffer->created : 0.0),
+                        buffer->destroyed,
+                        (buffer->destroyed ? buffer->flush_time / (double)buffer->destroyed : 0.0),
+                        buffer->flushes);
+            }
+            if (world.has<Prefabs>())
+            {
+                const auto* prefabs = world.get<Prefabs>();
+                if (prefabs->spawned)
+                    Log::Logger::instance("engine")->trace("Prefabs: {} instances spawned ({:0.2f} us each)",
+                        prefabs->spawned,
+                        prefabs->spawn_time / (double)prefabs->spawned);
+            }
+            event_count     = 0;
+            destroyed_count = 0;
+            tick_count      = 0;
+            dropped_ticks   = 0;
+            script_time     = 0.0;
+            script_calls    = 0;
+            system_time     = 0.0;
+            system_batches  = 0;
         }
     }
 }
@@ -223,10 +445,20 @@ Core::Core(const Application& app) :
     window(app.size, app.name)
 {   
     Log::Logger::instance("engine")->info("Core and context started");
+
+    // S2D_PROFILE=<file> profiles the scripts from the start and writes the folded stacks on exit
+    if (std::getenv("S2D_PROFILE")) Lua::Profiler::instance().start();
 }
 
 Core::~Core()
 {
+    if (const char* filename = std::getenv("S2D_PROFILE"))
+    {
+        Lua::Profiler::instance().stop();
+        if (Lua::Profiler::instance().dump(filename))
+            Log::Logger::instance("engine")->info("Wrote script profile to \"{}\"", filename);
+    }
+
     while (_scenes.size()) { delete _scenes.top(); _scenes.pop(); }
 }
 }
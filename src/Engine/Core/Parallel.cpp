@@ -0,0 +1,112 @@
+#include <Simple2D/Engine/Core.hpp>
+#include <Simple2D/Engine/Commands.hpp>
+#include <Simple2D/Engine/ThreadPool.hpp>
+
+#include <Simple2D/Engine/LuaLib/Entity.hpp>
+#include <Simple2D/Engine/LuaLib/World.hpp>
+
+#include <Simple2D/Log/Log.hpp>
+
+#include <atomic>
+#include <unordered_map>
+
+namespace S2D::Engine
+{
+
+uint64_t Core::updateParallel(Scene* scene, ThreadPool& workers)
+{
+    auto& world = scene->world;
+    const uint32_t threads = workers.size();
+
+    // A Lua state can only run on one thread at a time, so the unit of work is a runtime
+    // with every script instance living in it
+    struct Group
+    {
+        Lua::Runtime* runtime;
+        std::vector<std::pair<flecs::entity_t, Script::Instance*>> scripts;
+    };
+
+    uint64_t calls = 0;
+    std::vector<Group> groups;
+    std::unordered_map<Lua::Runtime*, uint32_t> group_index;
+    scene->scripts.each([&](flecs::entity e, Script& script)
+    {
+        if (!e.is_alive() || isDestroyQueued(world, e.raw_id())) return;
+        calls++;
+
+        for (auto& instance : script.runtime)
+        {
+            S2D_ASSERT(instance.runtime, "Script runtime is null!");
+            const auto [it, inserted] = group_index.try_emplace(instance.runtime.get(), groups.size());
+            if (inserted) groups.push_back({ instance.runtime.get(), {} });
+            groups[it->second].scripts.emplace_back(e.raw_id(), &instance);
+        }
+    });
+    if (groups.empty()) return calls;
+
+    // Loggers are made on first use, make sure the workers only ever look them up
+    Log::Logger::instance("lua");
+    auto& log = Log::Logger::instance("engine");
+
+    // Every worker writes into its own stage, nothing reaches the world until readonly_end
+    const WorldHandle world_handle = { world.c_ptr(), scene };
+    world.set_stage_count(threads);
+    world.readonly_begin();
+
+    const auto update = [&](Group& group)
+    {
+        for (auto& [id, script] : group.scripts)
+        {
+            const EntityHandle entity_handle = { world.c_ptr(), id };
+            const auto call = [&](ScriptFunction function)
+            {
+                if (!group.runtime->hasFunction((uint32_t)function, script->env)) return;
+
+                const auto ret = group.runtime->runFunction<>(script->env, (uint32_t)function, world_handle, entity_handle);
+                if (!ret)
+                    log->error("Lua {}(...) error ({}) in \"{}\": {}",
+                        *function,
+                        (int)ret.error().code(),
+                        group.runtime->filename(),
+                        ret.error().message());
+            };
+
+            if (!script->started)
+            {
+                call(ScriptFunction::Start);
+                script->started = true;
+            }
+            call(ScriptFunction::Update);
+        }
+    };
+
+    std::atomic<uint32_t> next = 0;
+    workers.run([&](uint32_t worker)
+    {
+        setStage(world.get_stage(worker).c_ptr());
+
+        if (Script::Deterministic)
+        {
+            // Same slice for the same worker every frame, so the stages merge in a fixed order
+            const std::size_t begin = groups.size() *  worker      / threads;
+            const std::size_t end   = groups.size() * (worker + 1) / threads;
+            for (std::size_t i = begin; i < end; i++) update(groups[i]);
+        }
+        else
+        {
+            // Whoever is free takes the next runtime, better when a few scripts are much heavier
+            for (uint32_t i = next++; i < groups.size(); i = next++) update(groups[i]);
+        }
+
+        setStage(nullptr);
+    });
+
+    world.readonly_end();
+
+    // Scripts added during the phase need their runtimes made on this thread
+    loadDeferredScripts(world);
+
+    return calls;
+}
+
+}
@@ -0,0 +1,72 @@
+#include <Simple2D/Engine/Core.hpp>
+
+#ifdef LUA_HOT_RELOAD
+
+#include <Simple2D/Engine/HotReload.hpp>
+
+#include <Simple2D/Log/Log.hpp>
+
+#include <unordered_set>
+
+namespace S2D::Engine
+{
+
+void Core::reload(Scene* scene)
+{
+    auto changes = HotReload::instance().poll();
+    if (changes.empty()) return;
+
+    auto& world = scene->world;
+    for (const auto& change : changes)
+    {
+        if (!change.error.empty())
+        {
+            Log::Logger::instance("engine")->error("Hot reload of \"{}\" failed, keeping the old version: {}", 
+                change.path.string(), change.error);
+            continue;
+        }
+
+        if (change.chunk.empty())
+        {
+            const auto count = scene->resources.reloadShaders(change.path);
+            if (count) Log::Logger::instance("engine")->info("Hot reloaded \"{}\" in {} shader(s)", change.path.string(), count);
+            continue;
+        }
+
+        // Only the runtimes running the changed file are touched, the same runtime
+        // can be shared between many entities and systems so reload each once
+        std::unordered_set<Lua::Runtime*> runtimes;
+        const auto collect = [&](Lua::Runtime* runtime)
+        {
+            if (runtime && runtime->path() == change.path) runtimes.insert(runtime);
+        };
+
+        scene->scripts.each([&](flecs::entity e, Script& script)
+        {
+            for (auto& instance : script.runtime) collect(instance.runtime.get());
+        });
+
+        if (world.has<LuaSystems>())
+            for (auto& system : world.get_mut<LuaSystems>()->systems) collect(system.script.runtime.get());
+
+        if (world.has<ScriptPool>())
+            for (auto& [name, free] : world.get_mut<ScriptPool>()->free)
+                for (auto& instance : free) collect(instance.runtime.get());
+
+        if (world.has<ScriptCache>())
+            for (auto& [name, runtime] : world.get_mut<ScriptCache>()->runtimes) collect(runtime.get());
+
+        for (auto* runtime : runtimes)
+        {
+            const auto res = runtime->reload(change.chunk);
+            if (!res)
+                Log::Logger::instance("engine")->error("Hot reload of \"{}\" failed: {}", change.path.string(), res.error().message());
+        }
+
+        Log::Logger::instance("engine")->info("Hot reloaded \"{}\" in {} runtime(s)", change.path.string(), runtimes.size());
+    }
+}
+
+}
+
+#endif
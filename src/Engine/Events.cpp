@@ -0,0 +1,224 @@
+#include <Simple2D/Engine/Events.hpp>
+#include <Simple2D/Engine/Components.hpp>
+
+#include <Simple2D/Engine/LuaLib/Entity.hpp>
+#include <Simple2D/Engine/LuaLib/Events.hpp>
+#include <Simple2D/Engine/LuaLib/World.hpp>
+
+#include <Simple2D/Log/Log.hpp>
+
+#include <algorithm>
+#include <mutex>
+
+namespace S2D::Engine
+{
+
+/* struct EventBus */
+EventBus::EventBus()
+{
+    for (uint32_t i = 0; i < (uint32_t)EventType::Count; i++)
+        intern(*(EventType)i);
+}
+
+uint32_t EventBus::intern(const std::string& name)
+{
+    const auto [it, inserted] = ids.try_emplace(name, (uint32_t)names.size());
+    if (inserted) names.push_back(name);
+    return it->second;
+}
+
+void EventBus::push(const Event& event)
+{
+    if (event.type >= queues.size()) queues.resize(names.size());
+    queues[event.type].push_back(event);
+}
+
+void EventBus::subscribe(flecs::entity_t entity, uint32_t type)
+{
+    const auto subscription = std::pair(entity, type);
+    if (std::find(subscriptions.begin(), subscriptions.end(), subscription) == subscriptions.end())
+        subscriptions.push_back(subscription);
+}
+
+void EventBus::unsubscribe(flecs::entity_t entity, uint32_t type)
+{
+    // Only marked, so unsubscribing from inside Events(...) doesn't move the ones being dispatched
+    for (auto& subscription : subscriptions)
+        if (subscription == std::pair(entity, type)) subscription.second = UINT32_MAX;
+}
+
+EventBus& eventBus(flecs::world& world)
+{
+    if (!world.has<EventBus>()) world.set<EventBus>({});
+    return *world.get_mut<EventBus>();
+}
+
+// Emits and subscriptions made from the workers of the parallel phase, applied when dispatching
+enum class DeferredOp { Emit, Subscribe, Unsubscribe };
+static std::mutex deferred_mutex;
+static std::vector<std::tuple<flecs::world_t*, DeferredOp, std::string, Event>> deferred_events;
+
+void emitEvent(flecs::world_t* world, const std::string& name, Event event)
+{
+    if (stage(world) != world)
+    {
+        std::scoped_lock lock(deferred_mutex);
+        deferred_events.emplace_back(world, DeferredOp::Emit, name, event);
+        return;
+    }
+
+    flecs::world w(world);
+    auto& bus = eventBus(w);
+    event.type = bus.intern(name);
+    bus.push(event);
+}
+
+void subscribeEvent(flecs::world_t* world, flecs::entity_t entity, const std::string& name, bool subscribe)
+{
+    if (stage(world) != world)
+    {
+        Event event;
+        event.source = entity;
+
+        std::scoped_lock lock(deferred_mutex);
+        deferred_events.emplace_back(world, (subscribe ? DeferredOp::Subscribe : DeferredOp::Unsubscribe), name, event);
+        return;
+    }
+
+    flecs::world w(world);
+    auto& bus = eventBus(w);
+    if (subscribe) bus.subscribe(entity, bus.intern(name));
+    else bus.unsubscribe(entity, bus.intern(name));
+}
+
+static void applyDeferred(flecs::world& world)
+{
+    decltype(deferred_events) deferred;
+    {
+        std::scoped_lock lock(deferred_mutex);
+        if (deferred_events.empty()) return;
+
+        // Leave the ones for other worlds where they are
+        auto it = std::stable_partition(deferred_events.begin(), deferred_events.end(),
+            [&](const auto& event) { return std::get<0>(event) != world.c_ptr(); });
+        deferred.assign(std::make_move_iterator(it), std::make_move_iterator(deferred_events.end()));
+        deferred_events.erase(it, deferred_events.end());
+    }
+
+    auto& bus = eventBus(world);
+    for (auto& [w, op, name, event] : deferred)
+    {
+        const auto type = bus.intern(name);
+        switch (op)
+        {
+        case DeferredOp::Emit:        event.type = type; bus.push(event);     break;
+        case DeferredOp::Subscribe:   bus.subscribe(event.source, type);      break;
+        case DeferredOp::Unsubscribe: bus.unsubscribe(event.source, type);    break;
+        }
+    }
+}
+
+uint64_t dispatchEvents(const WorldHandle& world_handle)
+{
+    auto world = flecs::world(world_handle.world);
+    applyDeferred(world);
+    if (!world.has<EventBus>()) return 0;
+
+    auto& log = Log::Logger::instance("engine");
+    auto* bus = world.get_mut<EventBus>();
+
+    // Anything emitted from here on goes into the other set of queues
+    std::swap(bus->queues, bus->dispatching);
+    auto& queues = bus->dispatching;
+    queues.resize(bus->names.size());
+
+    // Collisions only go to the entity that collided, sorting gives each one a contiguous run
+    auto& collisions = queues[(uint32_t)EventType::Collision];
+    std::stable_sort(collisions.begin(), collisions.end(),
+        [](const Event& a, const Event& b) { return a.source < b.source; });
+
+    // Scripts defining Collide(world, entity, collision) still get one call per collision
+    for (const auto& collision : collisions)
+    {
+        flecs::entity entity(world, collision.source);
+        if (!entity.is_alive() || !entity.has<Script>()) continue;
+
+        const EntityHandle entity_handle = { world.c_ptr(), collision.source };
+        for (auto& script : entity.get_mut<Script>()->runtime)
+        {
+            if (!script.runtime->hasFunction((uint32_t)ScriptFunction::Collide, script.env)) continue;
+
+            Lua::Table table;
+            const auto res = script.runtime->runFunction<>(script.env, (uint32_t)ScriptFunction::Collide, world_handle, entity_handle, table);
+            if (!res)
+                log->error("Lua Collide(...) error ({}) in \"{}\": {}",
+                    (int)res.error().code(),
+                    script.runtime->filename(),
+                    res.error().message());
+        }
+    }
+
+    // Drop unsubscribed and dead entities, then group the rest by entity
+    auto& subscriptions = bus->subscriptions;
+    subscriptions.erase(std::remove_if(subscriptions.begin(), subscriptions.end(),
+        [&](const auto& subscription)
+        {
+            return subscription.second == UINT32_MAX || !world.is_alive(subscription.first);
+        }), subscriptions.end());
+    std::sort(subscriptions.begin(), subscriptions.end());
+
+    uint64_t delivered = 0;
+
+    // Subscriptions made by the scripts below land past the end and start next frame
+    const std::size_t count = subscriptions.size();
+    for (std::size_t begin = 0, end = 0; begin < count; begin = end)
+    {
+        const auto id = subscriptions[begin].first;
+        for (end = begin; end < count && subscriptions[end].first == id; end++);
+
+        bus->batch.clear();
+        for (std::size_t i = begin; i < end; i++)
+        {
+            const auto type = subscriptions[i].second;
+            if (type >= queues.size()) continue;
+            const auto& queue = queues[type];
+
+            if (type == (uint32_t)EventType::Collision)
+            {
+                Event key;
+                key.source = id;
+                const auto range = std::equal_range(queue.begin(), queue.end(), key,
+                    [](const Event& a, const Event& b) { return a.source < b.source; });
+                for (auto it = range.first; it != range.second; it++) bus->batch.push_back(&*it);
+            }
+            else for (const auto& event : queue)
+                if (!event.target || event.target == id) bus->batch.push_back(&event);
+        }
+
+        flecs::entity entity(world, id);
+        if (bus->batch.empty() || !entity.is_alive() || !entity.has<Script>()) continue;
+
+        const EntityHandle entity_handle = { world.c_ptr(), id };
+        for (auto& script : entity.get_mut<Script>()->runtime)
+        {
+            if (!script.runtime->hasFunction((uint32_t)ScriptFunction::Events, script.env)) continue;
+
+            bus->batches++;
+            const EventBatchHandle batch_handle = { world.c_ptr(), bus, bus->batch.data(), (int32_t)bus->batch.size(), EventBatch::epoch };
+            const auto res = script.runtime->runFunction<>(script.env, (uint32_t)ScriptFunction::Events, world_handle, entity_handle, batch_handle);
+            EventBatch::epoch++;
+            if (!res)
+                log->error("Lua Events(...) error ({}) in \"{}\": {}",
+                    (int)res.error().code(),
+                    script.runtime->filename(),
+                    res.error().message());
+        }
+        delivered += bus->batch.size();
+    }
+    bus->dispatched += delivered;
+
+    for (auto& queue : bus->dispatching) queue.clear();
+    return delivered;
+}
+
+}
@@ -0,0 +1,155 @@
+#include <Simple2D/Engine/HotReload.hpp>
+
+#ifdef LUA_HOT_RELOAD
+
+#include <chrono>
+
+#ifdef __linux__
+#   include <sys/inotify.h>
+#   include <poll.h>
+#   include <unistd.h>
+#endif
+
+namespace S2D::Engine
+{
+
+HotReload& HotReload::instance()
+{
+    static HotReload hot_reload;
+    return hot_reload;
+}
+
+HotReload::HotReload() :
+    _running(false)
+{
+#   ifdef __linux__
+    _fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#   endif
+}
+
+HotReload::~HotReload()
+{
+    _running = false;
+    if (_thread.joinable()) _thread.join();
+
+#   ifdef __linux__
+    if (_fd >= 0) close(_fd);
+#   endif
+}
+
+void HotReload::watch(const std::filesystem::path& filename)
+{
+    std::error_code code;
+    const auto path = std::filesystem::weakly_canonical(filename, code);
+    if (code) return;
+
+    {
+        std::scoped_lock lock(_mutex);
+        if (_files.count(path.string())) return;
+
+        const auto modified = std::filesystem::last_write_time(path, code);
+        _files.insert(std::pair(path.string(), code ? std::filesystem::file_time_type::min() : modified));
+
+#       ifdef __linux__
+        // Editors usually save by writing a new file and renaming it over the old one,
+        // so watch the directory instead of the file
+        if (_fd >= 0)
+        {
+            const auto directory = path.parent_path();
+            const int wd = inotify_add_watch(_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+            if (wd >= 0) _directories.insert(std::pair(wd, directory));
+        }
+#       endif
+    }
+
+    if (!_running.exchange(true))
+        _thread = std::thread(&HotReload::_run, this);
+}
+
+std::vector<HotReload::Change> HotReload::poll()
+{
+    std::vector<Change> changes;
+
+    std::scoped_lock lock(_mutex);
+    if (_changes.empty()) return changes;
+
+    changes.reserve(_changes.size());
+    for (auto& [path, change] : _changes)
+        changes.push_back(std::move(change));
+    _changes.clear();
+
+    return changes;
+}
+
+void HotReload::_changed(const std::filesystem::path& filename)
+{
+    Change change;
+    change.path = filename;
+
+    if (filename.extension() == ".lua")
+    {
+        auto res = Lua::Runtime::compile(filename.string());
+        if (res) change.chunk = std::move(res.value());
+        else     change.error = res.error().message();
+    }
+
+    std::scoped_lock lock(_mutex);
+    _changes[filename.string()] = std::move(change);
+}
+
+void HotReload::_run()
+{
+    using namespace std::chrono_literals;
+
+    while (_running)
+    {
+        std::vector<std::filesystem::path> changed;
+
+#       ifdef __linux__
+        if (_fd >= 0)
+        {
+            pollfd fd = { _fd, POLLIN, 0 };
+            if (::poll(&fd, 1, 100) <= 0) continue;
+
+            alignas(inotify_event) char buffer[4096];
+            ssize_t length;
+            while ((length = read(_fd, buffer, sizeof(buffer))) > 0)
+            {
+                for (char* ptr = buffer; ptr < buffer + length; )
+                {
+                    const auto* event = reinterpret_cast<const inotify_event*>(ptr);
+                    ptr += sizeof(inotify_event) + event->len;
+                    if (!event->len) continue;
+
+                    std::scoped_lock lock(_mutex);
+                    if (!_directories.count(event->wd)) continue;
+
+                    const auto path = _directories.at(event->wd) / event->name;
+                    if (_files.count(path.string())) changed.push_back(path);
+                }
+            }
+        }
+        else
+#       endif
+        {
+            // No change notifications available, fall back to checking the write times
+            std::this_thread::sleep_for(250ms);
+
+            std::scoped_lock lock(_mutex);
+            for (auto& [path, last] : _files)
+            {
+                std::error_code code;
+                const auto modified = std::filesystem::last_write_time(path, code);
+                if (code || modified == last) continue;
+                last = modified;
+                changed.push_back(path);
+            }
+        }
+
+        for (const auto& path : changed) _changed(path);
+    }
+}
+
+}
+
+#endif
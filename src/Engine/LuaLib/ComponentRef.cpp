@@ -0,0 +1,134 @@
+#include <Simple2D/Engine/LuaLib/ComponentRef.hpp>
+#include <Simple2D/Engine/LuaLib/System.hpp>
+#include <Simple2D/Engine/LuaLib/World.hpp>
+
+#include <Simple2D/Def.hpp>
+
+#include "../../Lua/Lua.cpp"
+
+#include <cstring>
+
+namespace S2D::Engine
+{
+
+static void
+pushField(Lua::State L, const Field& field, const char* ptr)
+{
+    switch (field.type)
+    {
+    case Field::Type::Number:   lua_pushnumber (STATE, *reinterpret_cast<const Lua::Number*>(ptr));            break;
+    case Field::Type::Unsigned: lua_pushnumber (STATE, *reinterpret_cast<const uint32_t*>(ptr));               break;
+    case Field::Type::Enum:     lua_pushnumber (STATE, *reinterpret_cast<const int*>(ptr));                    break;
+    case Field::Type::Boolean:  lua_pushboolean(STATE, *reinterpret_cast<const Lua::Boolean*>(ptr));           break;
+    case Field::Type::String:   lua_pushstring (STATE, reinterpret_cast<const Lua::String*>(ptr)->c_str());    break;
+    default: lua_pushnil(STATE); break;
+    }
+}
+
+static void
+writeField(Lua::State L, int index, const Field& field, char* ptr)
+{
+    switch (field.type)
+    {
+    case Field::Type::Number:   *reinterpret_cast<Lua::Number*>(ptr)  = (Lua::Number)lua_tonumber(STATE, index); break;
+    case Field::Type::Unsigned: *reinterpret_cast<uint32_t*>(ptr)     = (uint32_t)lua_tonumber(STATE, index);    break;
+    case Field::Type::Enum:     *reinterpret_cast<int*>(ptr)          = (int)lua_tonumber(STATE, index);         break;
+    case Field::Type::Boolean:  *reinterpret_cast<Lua::Boolean*>(ptr) = lua_toboolean(STATE, index);             break;
+    case Field::Type::String:
+    {
+        S2D_ASSERT(lua_isstring(STATE, index), "Field expects a string");
+        *reinterpret_cast<Lua::String*>(ptr) = lua_tostring(STATE, index);
+        break;
+    }
+    case Field::Type::Struct:
+    {
+        // Assigning a table to a struct member copies over whichever keys it has
+        S2D_ASSERT(lua_istable(STATE, index), "Field expects a table");
+        index = lua_absindex(STATE, index);
+        for (const auto& member : field.fields)
+        {
+            if (lua_getfield(STATE, index, member.name) != LUA_TNIL)
+                writeField(L, -1, member, ptr + member.offset);
+            lua_pop(STATE, 1);
+        }
+        break;
+    }
+    }
+}
+
+int ComponentRef::index(Lua::State L)
+{
+    const auto* handle = Lua::toUserdata<ComponentHandle>(L, ComponentHandle::TypeName, 1);
+    S2D_ASSERT(handle, "Not a component reference");
+    if (handle->data && handle->epoch != System::epoch)
+        return luaL_error(STATE, "Row of a system's column used after its System call returned");
+
+    const char* key = lua_tostring(STATE, 2);
+    if (!key) return 0;
+
+    flecs::entity entity(stage(handle->world), handle->entity);
+    const auto* field = handle->field->find(key);
+    if (!field)
+    {
+        // Mirror the bookkeeping keys of the copied component tables
+        if (!strcmp(key, "good")) { lua_pushboolean(STATE, handle->data || (entity.is_alive() && entity.has(handle->component))); return 1; }
+        if (!strcmp(key, "type")) { lua_pushnumber(STATE, (Lua::Number)handle->component); return 1; }
+        return 0;
+    }
+
+    if (field->type == Field::Type::Struct)
+    {
+        auto member = *handle;
+        member.field   = field;
+        member.offset += field->offset;
+        Lua::pushUserdata(L, ComponentHandle::TypeName, member);
+        return 1;
+    }
+
+    const auto* data = (handle->data ? handle->data : static_cast<const char*>(entity.get(handle->component)));
+    if (!data) return 0;
+
+    pushField(L, *field, data + handle->offset + field->offset);
+    return 1;
+}
+
+int ComponentRef::newIndex(Lua::State L)
+{
+    const auto* handle = Lua::toUserdata<ComponentHandle>(L, ComponentHandle::TypeName, 1);
+    S2D_ASSERT(handle, "Not a component reference");
+    if (handle->data && handle->epoch != System::epoch)
+        return luaL_error(STATE, "Row of a system's column used after its System call returned");
+
+    const char* key = lua_tostring(STATE, 2);
+    const auto* field = (key ? handle->field->find(key) : nullptr);
+    if (!field) return luaL_error(STATE, "Component has no field '%s'", key ? key : "?");
+
+    // Columns are written in place, the query iterating them already tracks the change
+    if (handle->data)
+    {
+        writeField(L, 3, *field, handle->data + handle->offset + field->offset);
+        return 0;
+    }
+
+    // A reference kept from the main thread can't be written from a parallel script either
+    if (stage(handle->world) != handle->world)
+        return luaL_error(STATE, "Component references can't be written from a parallel script");
+
+    flecs::entity entity(handle->world, handle->entity);
+    S2D_ASSERT(entity.is_alive() && entity.has(handle->component), "Entity missing referenced component");
+
+    auto* data = static_cast<char*>(entity.get_mut(handle->component));
+    writeField(L, 3, *field, data + handle->offset + field->offset);
+    entity.modified(handle->component);
+
+    return 0;
+}
+
+ComponentRef::ComponentRef() : Base("ComponentRef",
+    {
+        { "__index",    ComponentRef::index    },
+        { "__newindex", ComponentRef::newIndex }
+    })
+{   }
+
+}
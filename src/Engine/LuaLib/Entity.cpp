@@ -1,11 +1,37 @@
 #include <Simple2D/Engine/LuaLib/Entity.hpp>
 
+#include <Simple2D/Engine/Commands.hpp>
 #include <Simple2D/Engine/Components.hpp>
+#include <Simple2D/Engine/LuaLib/ComponentRef.hpp>
+#include <Simple2D/Engine/LuaLib/World.hpp>
 #include <Simple2D/Log/Library.hpp>
 #include <Simple2D/Def.hpp>
 
+#include "../../Lua/Lua.cpp"
+
 #include <flecs.h>
 
+namespace S2D::Lua::CompileTime
+{
+    bool
+    TypeMap<Engine::EntityHandle>::check(State L)
+    {
+        return toUserdata<Engine::EntityHandle>(L, Engine::EntityHandle::TypeName);
+    }
+
+    void
+    TypeMap<Engine::EntityHandle>::push(State L, const Engine::EntityHandle& val)
+    {
+        pushCachedUserdata(L, Engine::EntityHandle::TypeName, (int64_t)val.entity, val);
+    }
+
+    Engine::EntityHandle
+    TypeMap<Engine::EntityHandle>::construct(State L)
+    {
+        return *toUserdata<Engine::EntityHandle>(L, Engine::EntityHandle::TypeName);
+    }
+}
+
 namespace S2D::Engine
 {
 
@@ -14,7 +40,7 @@ namespace S2D::Engine
         const Lua::Table& entity_or_component)
     {
         const auto e_id  = (uint64_t)*entity_or_component.get<void**>("entity");
-        const auto w_ptr = (flecs::world_t*)*entity_or_component.get<void**>("world");
+        const auto w_ptr = stage((flecs::world_t*)*entity_or_component.get<void**>("world"));
 
         return {
             flecs::world(w_ptr),
@@ -22,85 +48,139 @@ namespace S2D::Engine
         };
     }
 
-    int Entity::getComponent(Lua::State L)
+    std::pair<flecs::world, flecs::entity>
+    Entity::extractWorldInfo(
+        const Lua::TableView& entity_or_component)
     {
-        const auto [entity_table, component_id] = extractArgs<Lua::Table, Lua::Number>(L);
-        const auto world_info = extractWorldInfo(entity_table);
-        const auto& world  = std::get<0>(world_info);
-        const auto& entity = std::get<1>(world_info);
+        const auto e_id  = (uint64_t)*entity_or_component.get<void**>("entity");
+        const auto w_ptr = stage((flecs::world_t*)*entity_or_component.get<void**>("world"));
 
-        const std::size_t ID = component_id;
+        return {
+            flecs::world(w_ptr),
+            flecs::entity(w_ptr, e_id)
+        };
+    }
+
+    std::pair<flecs::world, flecs::entity>
+    Entity::extractWorldInfo(
+        const EntityHandle& entity)
+    {
+        const auto world = stage(entity.world);
+        return {
+            flecs::world(world),
+            flecs::entity(world, entity.entity)
+        };
+    }
 
-        using namespace Util::CompileTime;
+    int Entity::getComponent(Lua::State L)
+    {
+        const auto [entity_handle, component_id] = viewArgs<EntityHandle, Lua::Number>(L);
+        auto [ world, entity ] = extractWorldInfo(entity_handle);
 
-        Lua::Table table;
+        const std::size_t ID = component_id;
 
-        bool found = false;
-        static_for<(int)Name::Count>([&](auto n)
-        {
-            if (found) return;
-
-            constexpr std::size_t i = n;
-            constexpr auto component = static_cast<Name>(i);
-            auto id = world.component<ComponentData<component>>().raw_id();
-            if (id == ID)
-            {
-                // Found
-                const void* comp = entity.get(id);
-                S2D_ASSERT(comp, "Component is null");
-                table.fromTable(Component<component>::getTable(*(const ComponentData<component>*)comp));
-                table.set("good", true);
-                table.set("type", (Lua::Number)ID);
-                table.set("entity", (void*)entity.raw_id());
-                table.set("world", (void*)world.c_ptr());
-                found = true;
-            }
-        });
-
-        if (!found)
+        const auto* info = componentTable(entity_handle.world).find(ID);
+        if (!info || !entity.has(ID))
         {
+            Lua::Table table;
             table.set("good", false);
             table.set("what", std::string("Entity doesn't have component"));
             table.toStack(L);
             return 1;
         }
 
-        table.toStack(L);
+        const void* comp = entity.get(ID);
+        S2D_ASSERT(comp, "Component is null");
+
+        // Fields the engine reads back in setComponent, set straight on the pushed table
+        info->push(L, comp);
+        lua_pushboolean(STATE, true);
+        lua_setfield(STATE, -2, "good");
+        lua_pushnumber(STATE, (Lua::Number)ID);
+        lua_setfield(STATE, -2, "type");
+        Lua::CompileTime::TypeMap<void*>::push(L, (void*)entity.raw_id());
+        lua_setfield(STATE, -2, "entity");
+        Lua::CompileTime::TypeMap<void*>::push(L, (void*)entity_handle.world);
+        lua_setfield(STATE, -2, "world");
+
+        return 1;
+    }
+
+    int Entity::getComponentRef(Lua::State L)
+    {
+        const auto [entity_handle, component_id] = viewArgs<EntityHandle, Lua::Number>(L);
+        auto [ world, entity ] = extractWorldInfo(entity_handle);
+
+        const std::size_t ID = component_id;
+
+        // On a stage writes would be deferred copies while reads see the committed value, see getComponentPtr
+        const Field* layout = getComponentLayout(ID, world);
+        if (!layout || !entity.has(ID) || stage(entity_handle.world) != entity_handle.world)
+        {
+            lua_pushnil(STATE);
+            return 1;
+        }
+
+        ComponentHandle handle;
+        handle.world     = entity_handle.world;
+        handle.entity    = entity.raw_id();
+        handle.component = ID;
+        handle.field     = layout;
+        handle.offset    = 0;
+        handle.data      = nullptr;
+        handle.epoch     = 0;
+        Lua::pushUserdata(L, ComponentHandle::TypeName, handle);
+
+        return 1;
+    }
+
+    int Entity::getComponentPtr(Lua::State L)
+    {
+        const auto [entity_handle, component_id] = viewArgs<EntityHandle, Lua::Number>(L);
+        auto [ world, entity ] = extractWorldInfo(entity_handle);
+
+        const auto ID = (flecs::id_t)component_id;
+
+        // On a stage get_mut is deferred and would point into the command queue, not the component
+        if (!entity.is_alive() || !entity.has(ID) || stage(entity_handle.world) != entity_handle.world)
+        {
+            lua_pushnil(STATE);
+            return 1;
+        }
+
+        // The writes come after this, but before anything later in the tick looks for changes
+        auto* data = entity.get_mut(ID);
+        entity.modified(ID);
+        lua_pushlightuserdata(STATE, data);
         return 1;
     }
 
     int Entity::setComponent(Lua::State L)
     {
-        using namespace Util::CompileTime;
+        // References already wrote through to the world, nothing to copy back
+        if (Lua::toUserdata<ComponentHandle>(L, ComponentHandle::TypeName))
+        {
+            lua_settop(STATE, 0);
+            Lua::CompileTime::TypeMap<Lua::Boolean>::push(L, true);
+            return 1;
+        }
 
-        const auto [entity_table, component_table] = extractArgs<Lua::Table, Lua::Table>(L);
+        const auto [entity_handle, component_table] = viewArgs<EntityHandle, Lua::Table>(L);
 
         S2D_ASSERT(component_table.get<Lua::Boolean>("good"), "Component is not good");
 
-        const auto world_info = extractWorldInfo(entity_table);
-        const auto& world  = std::get<0>(world_info);
-        const auto& entity = std::get<1>(world_info);
+        auto [ world, entity ] = extractWorldInfo(entity_handle);
 
         // Make sure the component is in the entity
-        const auto component_id = component_table.get<Lua::Number>("type");
-        const auto& table = component_table;
+        const auto component_id = (flecs::id_t)component_table.get<Lua::Number>("type");
+        const auto* info = componentTable(entity_handle.world).find(component_id);
 
-        bool found = false;
-        static_for<(int)Name::Count>([&](auto n)
+        const bool found = (info != nullptr);
+        if (found)
         {
-            if (found) return;
-
-            constexpr std::size_t i = n;
-            constexpr auto component = static_cast<Name>(i);
-            auto id = world.component<ComponentData<component>>().raw_id();
-            if (id == component_id)
-            {
-                // Found
-                void* comp = entity.get_mut(id);
-                Component<component>::fromTable(table, comp);
-                found = true;
-            }
-        });
+            info->fromView(component_table, entity.get_mut(component_id));
+            entity.modified(component_id);
+        }
 
         Lua::CompileTime::TypeMap<Lua::Boolean>::push(L, found);
         return 1;
@@ -108,25 +188,30 @@ namespace S2D::Engine
 
     int Entity::destroy(Lua::State L)
     {
-        const auto [ entity_table ] = extractArgs<Lua::Table>(L);
-        auto [ world, entity ] = extractWorldInfo(entity_table);
-
-        if (entity.is_alive() && !entity.has<Dead>()) entity.add<Dead>();
+        const auto [ entity_handle ] = viewArgs<EntityHandle>(L);
+        queueDestroy(entity_handle.world, entity_handle.entity);
 
         return 0;
     }
 
     int Entity::addScript(Lua::State L)
     {
-        const auto [entity_table, filename] = extractArgs<Lua::Table, Lua::String>(L);
-        S2D_ASSERT(entity_table.get<Lua::Boolean>("good"), "Entity not good");
-        auto [ world, entity ] = extractWorldInfo(entity_table);
+        const auto [entity_handle, filename] = viewArgs<EntityHandle, Lua::String>(L);
+        auto [ world, entity ] = extractWorldInfo(entity_handle);
 
         S2D_ASSERT(entity.is_alive(), "Entity is dead");
+
+        // Runtimes aren't made from worker threads, the script is loaded once the stages merge
+        if (world.c_ptr() != entity_handle.world)
+        {
+            deferScript(entity_handle.world, entity.raw_id(), filename);
+            return 0;
+        }
+
         // TODO: Need to figure out why this set crashes in XCODE
         if (!entity.has<Engine::Script>()) entity.set<Engine::Script>({});
         auto* script = entity.get_mut<Engine::Script>();
-        loadScript(filename, world, *script);
+        loadScript(filename, world, entity, *script);
 
         return 0;
     }
@@ -135,6 +220,8 @@ namespace S2D::Engine
         {
             { "getComponent", Entity::getComponent },
             { "setComponent", Entity::setComponent },
+            { "getComponentRef", Entity::getComponentRef },
+            { "getComponentPtr", Entity::getComponentPtr },
             { "destroy",      Entity::destroy      },
             { "addScript",    Entity::addScript    }
         })
@@ -0,0 +1,112 @@
+#include <Simple2D/Engine/LuaLib/Events.hpp>
+#include <Simple2D/Engine/LuaLib/Entity.hpp>
+
+#include <Simple2D/Def.hpp>
+
+#include "../../Lua/Lua.cpp"
+
+namespace S2D::Lua::CompileTime
+{
+    bool
+    TypeMap<Engine::EventBatchHandle>::check(State L)
+    {
+        return toUserdata<Engine::EventBatchHandle>(L, Engine::EventBatchHandle::TypeName);
+    }
+
+    void
+    TypeMap<Engine::EventBatchHandle>::push(State L, const Engine::EventBatchHandle& val)
+    {
+        // Batches are delivered one at a time, so every call reuses the same block
+        pushCachedUserdata(L, Engine::EventBatchHandle::TypeName, 0, val);
+    }
+
+    Engine::EventBatchHandle
+    TypeMap<Engine::EventBatchHandle>::construct(State L)
+    {
+        return *toUserdata<Engine::EventBatchHandle>(L, Engine::EventBatchHandle::TypeName);
+    }
+}
+
+namespace S2D::Engine
+{
+
+int Events::subscribe(Lua::State L)
+{
+    const auto [ entity_handle, name ] = viewArgs<EntityHandle, Lua::String>(L);
+    subscribeEvent(entity_handle.world, entity_handle.entity, name, true);
+    return 0;
+}
+
+int Events::unsubscribe(Lua::State L)
+{
+    const auto [ entity_handle, name ] = viewArgs<EntityHandle, Lua::String>(L);
+    subscribeEvent(entity_handle.world, entity_handle.entity, name, false);
+    return 0;
+}
+
+int Events::emit(Lua::State L)
+{
+    const int args = lua_gettop(STATE);
+    S2D_ASSERT(args >= 2 && args <= 4, "Expected entity:emit(name [, value [, target]])");
+
+    const auto* entity_handle = Lua::toUserdata<EntityHandle>(L, EntityHandle::TypeName, 1);
+    S2D_ASSERT(entity_handle, "Not an entity");
+
+    Event event;
+    event.source = entity_handle->entity;
+    event.value  = (float)luaL_optnumber(STATE, 3, 0);
+    if (args == 4 && !lua_isnil(STATE, 4))
+    {
+        const auto* target = Lua::toUserdata<EntityHandle>(L, EntityHandle::TypeName, 4);
+        S2D_ASSERT(target, "Event target is not an entity");
+        event.target = target->entity;
+    }
+
+    emitEvent(entity_handle->world, luaL_checkstring(STATE, 2), event);
+    return 0;
+}
+
+Events::Events() : Base("Events",
+    {
+        { "subscribe",   Events::subscribe   },
+        { "unsubscribe", Events::unsubscribe },
+        { "emit",        Events::emit        }
+    })
+{   }
+
+int EventBatch::count(Lua::State L)
+{
+    const auto [ batch ] = viewArgs<EventBatchHandle>(L);
+    if (batch.epoch != EventBatch::epoch) return luaL_error(STATE, "Event batch used after its Events call returned");
+    lua_pushnumber(STATE, (Lua::Number)batch.count);
+    return 1;
+}
+
+int EventBatch::get(Lua::State L)
+{
+    const auto [ batch, index ] = viewArgs<EventBatchHandle, Lua::Number>(L);
+    if (batch.epoch != EventBatch::epoch) return luaL_error(STATE, "Event batch used after its Events call returned");
+
+    const auto i = (int32_t)index - 1;
+    S2D_ASSERT(i >= 0 && i < batch.count, "Event out of range");
+    const auto& event = *batch.events[i];
+
+    const auto& name = batch.bus->names[event.type];
+    lua_pushlstring(STATE, name.c_str(), name.size());
+    Lua::CompileTime::TypeMap<EntityHandle>::push(L, { batch.world, event.source });
+    if (event.target) Lua::CompileTime::TypeMap<EntityHandle>::push(L, { batch.world, event.target });
+    else lua_pushnil(STATE);
+    lua_pushnumber(STATE, event.vector.x);
+    lua_pushnumber(STATE, event.vector.y);
+    lua_pushnumber(STATE, event.value);
+    return 6;
+}
+
+EventBatch::EventBatch() : Base("EventBatch",
+    {
+        { "count", EventBatch::count },
+        { "get",   EventBatch::get   }
+    })
+{   }
+
+}
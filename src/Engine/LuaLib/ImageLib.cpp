@@ -12,7 +12,7 @@ int
 ImageLib::getSize(Lua::State L)
 {
     auto& logger = Log::Logger::instance("engine");
-    const auto [ resource ] = extractArgs<Lua::Table>(L);
+    const auto [ resource ] = viewArgs<Lua::Table>(L);
     LUA_EXCEPTION(resource.hasValue("resource"), "Resource missing reference");
 
     auto* image = (Graphics::Image*)*resource.get<void**>("resource");
@@ -31,7 +31,7 @@ int
 ImageLib::getPixel(Lua::State L)
 {
     auto& logger = Log::Logger::instance("engine");
-    const auto [ resource, x, y ] = extractArgs<Lua::Table, Lua::Number, Lua::Number>(L);
+    const auto [ resource, x, y ] = viewArgs<Lua::Table, Lua::Number, Lua::Number>(L);
     LUA_EXCEPTION(resource.hasValue("resource"), "Resource missing reference");
     LUA_EXCEPTION(x >= 0 && y >= 0, "Coordinates can not be negative");
 
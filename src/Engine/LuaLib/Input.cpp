@@ -17,7 +17,7 @@ namespace S2D::Engine
 
     int Input::getPressed(Lua::State L)
     {
-        const auto [ key_code ] = extractArgs<Lua::String>(L);
+        const auto [ key_code ] = viewArgs<Lua::String>(L);
         if (!global_state.count(key_code)) lua_pushboolean(STATE, false);
         else lua_pushboolean(STATE, (int)global_state.at(key_code) & (int)(KeyState::Press));
         return 1;
@@ -25,7 +25,7 @@ namespace S2D::Engine
 
     int Input::getDown(Lua::State L)
     {
-        const auto [ key_code ] = extractArgs<Lua::String>(L);
+        const auto [ key_code ] = viewArgs<Lua::String>(L);
         if (!global_state.count(key_code)) lua_pushboolean(STATE, false);
         else lua_pushboolean(STATE, (int)global_state.at(key_code) & (int)(KeyState::Down));
         return 1;
@@ -33,7 +33,7 @@ namespace S2D::Engine
 
     int Input::getReleased(Lua::State L)
     {
-        const auto [ key_code ] = extractArgs<Lua::String>(L);
+        const auto [ key_code ] = viewArgs<Lua::String>(L);
         if (!global_state.count(key_code)) lua_pushboolean(STATE, false);
         else lua_pushboolean(STATE, (int)global_state.at(key_code) & (int)(KeyState::Release));
         return 1;
@@ -17,7 +17,7 @@ int
 MeshLib::setPrimitiveType(Lua::State L)
 {
     auto& logger = Log::Logger::instance("engine");
-    const auto [ mesh_table, primitive_type ] = extractArgs<Lua::Table, Lua::Number>(L);
+    const auto [ mesh_table, primitive_type ] = viewArgs<Lua::Table, Lua::Number>(L);
     const auto [ world, entity ] = Entity::extractWorldInfo(mesh_table);
     LUA_EXCEPTION(entity.has<CustomMesh>(), "Entity missing custom mesh component");
     LUA_EXCEPTION(primitive_type <= (int)Primitive::Lines && primitive_type >= 0, "Incorrect primitive type given");
@@ -34,7 +34,7 @@ int
 MeshLib::getVertexCount(Lua::State L)
 {
     auto& logger = Log::Logger::instance("engine");
-    const auto [ mesh_table ] = extractArgs<Lua::Table>(L);
+    const auto [ mesh_table ] = viewArgs<Lua::Table>(L);
     const auto [ world, entity ] = Entity::extractWorldInfo(mesh_table);
     LUA_EXCEPTION(entity.has<CustomMesh>(), "Entity missing custom mesh component");
     
@@ -47,7 +47,7 @@ int
 MeshLib::pushVertex(Lua::State L)
 {
     auto& logger = Log::Logger::instance("engine");
-    const auto [ mesh_table, vertex ] = extractArgs<Lua::Table, Lua::Table>(L);
+    const auto [ mesh_table, vertex ] = viewArgs<Lua::Table, Lua::Table>(L);
     const auto [ world, entity ] = Entity::extractWorldInfo(mesh_table);
     LUA_EXCEPTION(entity.has<CustomMesh>(), "Entity missing custom mesh component");
 
@@ -1,6 +1,7 @@
 #include <Simple2D/Engine/LuaLib/ResLib.hpp>
 #include <Simple2D/Engine/LuaLib/Entity.hpp>
 #include <Simple2D/Engine/LuaLib/ImageLib.hpp>
+#include <Simple2D/Engine/LuaLib/World.hpp>
 
 #include <Simple2D/Engine/Core.hpp>
 
@@ -27,11 +28,11 @@ int
 ResLib::getResource(Lua::State L)
 {
     auto& logger = Log::Logger::instance("engine");
-    const auto [ world_table, type, name ] 
-        = extractArgs<Lua::Table, Lua::Number, Lua::String>(L);
+    const auto [ world_handle, type, name ] 
+        = extractArgs<WorldHandle, Lua::Number, Lua::String>(L);
     
-    LUA_EXCEPTION(world_table.hasValue("scene"), "World missing scene instance");
-    auto* scene = (Scene*)*world_table.get<void**>("scene");
+    LUA_EXCEPTION(world_handle.scene, "World missing scene instance");
+    auto* scene = (Scene*)world_handle.scene;
 
     LUA_EXCEPTION(type >= 0 && type <= (Lua::Number)(int)ResourceType::Image, "Resource type invalid!");
 
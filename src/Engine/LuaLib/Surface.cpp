@@ -11,7 +11,7 @@ namespace S2D::Engine
     int Surface::drawText(Lua::State L)
     {
         const auto [ surface_table, x, y, size, text, font ] = 
-            extractArgs<Lua::Table, Lua::Number, Lua::Number, Lua::Number, Lua::String, Lua::String>(L);
+            viewArgs<Lua::Table, Lua::Number, Lua::Number, Lua::Number, Lua::String, Lua::String>(L);
 
         LUA_ASSERT(surface_table.hasValue("scene"), "Surface missing scene");
         auto* scene = (Scene*)*surface_table.get<void**>("scene");
@@ -35,7 +35,7 @@ namespace S2D::Engine
     int Surface::drawTexture(Lua::State L)
     {
         const auto [ surface_table, name, type, transform_table ] = 
-            extractArgs<Lua::Table, Lua::String, Lua::Number, Lua::Table>(L);
+            viewArgs<Lua::Table, Lua::String, Lua::Number, Lua::Table>(L);
 
         LUA_ASSERT(surface_table.hasValue("scene"), "Surface missing scene");
         const auto* scene = (Scene*)*surface_table.get<void**>("scene");
@@ -69,7 +69,7 @@ namespace S2D::Engine
         float rotation = 0.f;
 
         transform_table.try_get<Lua::Table>("position", 
-            [&](const Lua::Table& table)
+            [&](const Lua::TableView& table)
             {
                 position.x = ( table.hasValue("x") ? table.get<Lua::Number>("x") : 0.f );
                 position.y = ( table.hasValue("y") ? table.get<Lua::Number>("y") : 0.f );
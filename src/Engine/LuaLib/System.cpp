@@ -0,0 +1,151 @@
+#include <Simple2D/Engine/LuaLib/System.hpp>
+#include <Simple2D/Engine/LuaLib/ComponentRef.hpp>
+#include <Simple2D/Engine/LuaLib/Entity.hpp>
+
+#include <Simple2D/Def.hpp>
+
+#include "../../Lua/Lua.cpp"
+
+namespace S2D::Lua::CompileTime
+{
+    bool
+    TypeMap<Engine::SystemIterHandle>::check(State L)
+    {
+        return toUserdata<Engine::SystemIterHandle>(L, Engine::SystemIterHandle::TypeName);
+    }
+
+    void
+    TypeMap<Engine::SystemIterHandle>::push(State L, const Engine::SystemIterHandle& val)
+    {
+        // Systems run one table at a time, so every call reuses the same block
+        pushCachedUserdata(L, Engine::SystemIterHandle::TypeName, 0, val);
+    }
+
+    Engine::SystemIterHandle
+    TypeMap<Engine::SystemIterHandle>::construct(State L)
+    {
+        return *toUserdata<Engine::SystemIterHandle>(L, Engine::SystemIterHandle::TypeName);
+    }
+}
+
+namespace S2D::Engine
+{
+
+#define CHECK_EPOCH(handle) \
+    if ((handle).epoch != System::epoch) return luaL_error(STATE, "System iterator used after its System call returned")
+
+int System::count(Lua::State L)
+{
+    const auto [ iter ] = extractArgs<SystemIterHandle>(L);
+    CHECK_EPOCH(iter);
+    lua_pushnumber(STATE, (Lua::Number)iter.count);
+    return 1;
+}
+
+int System::entity(Lua::State L)
+{
+    const auto [ iter, index ] = extractArgs<SystemIterHandle, Lua::Number>(L);
+    CHECK_EPOCH(iter);
+
+    const auto row = (int32_t)index - 1;
+    S2D_ASSERT(row >= 0 && row < iter.count, "Row out of range");
+
+    Lua::CompileTime::TypeMap<EntityHandle>::push(L, { iter.world, iter.entities[row] });
+    return 1;
+}
+
+int System::field(Lua::State L)
+{
+    const auto [ iter, index ] = extractArgs<SystemIterHandle, Lua::Number>(L);
+    CHECK_EPOCH(iter);
+
+    const auto term = (std::size_t)index - 1;
+    if (term >= iter.system->components.size() || (iter.shared & (1ull << term)))
+    {
+        lua_pushnil(STATE);
+        return 1;
+    }
+
+    ColumnHandle column;
+    column.world     = iter.world;
+    column.entities  = iter.entities;
+    column.component = iter.system->components[term];
+    column.layout    = iter.system->layouts[term];
+    column.data      = static_cast<char*>(iter.columns[term]);
+    column.stride    = iter.sizes[term];
+    column.count     = iter.count;
+    column.epoch     = iter.epoch;
+
+    // Cached per term so fetching the columns each call doesn't allocate
+    Lua::pushCachedUserdata(L, ColumnHandle::TypeName, (int64_t)term, column);
+    return 1;
+}
+
+int System::fieldPtr(Lua::State L)
+{
+    const auto [ iter, index ] = extractArgs<SystemIterHandle, Lua::Number>(L);
+    CHECK_EPOCH(iter);
+
+    const auto term = (std::size_t)index - 1;
+    if (term >= iter.system->components.size() || !iter.columns[term] || (iter.shared & (1ull << term)))
+    {
+        lua_pushnil(STATE);
+        return 1;
+    }
+
+    lua_pushlightuserdata(STATE, iter.columns[term]);
+    lua_pushnumber(STATE, (Lua::Number)iter.system->components[term]);
+    return 2;
+}
+
+System::System() : Base("SystemIter",
+    {
+        { "count",    System::count    },
+        { "entity",   System::entity   },
+        { "field",    System::field    },
+        { "fieldPtr", System::fieldPtr }
+    })
+{   }
+
+int Column::index(Lua::State L)
+{
+    const auto* column = Lua::toUserdata<ColumnHandle>(L, ColumnHandle::TypeName, 1);
+    S2D_ASSERT(column, "Not a column");
+    CHECK_EPOCH(*column);
+
+    const auto row = (int32_t)lua_tointeger(STATE, 2) - 1;
+    if (row < 0 || row >= column->count || !column->data) return 0;
+
+    ComponentHandle handle;
+    handle.world     = column->world;
+    handle.entity    = column->entities[row];
+    handle.component = column->component;
+    handle.field     = column->layout;
+    handle.offset    = 0;
+    handle.data      = column->data + row * column->stride;
+    handle.epoch     = column->epoch;
+    Lua::pushUserdata(L, ComponentHandle::TypeName, handle);
+
+    return 1;
+}
+
+int Column::length(Lua::State L)
+{
+    const auto* column = Lua::toUserdata<ColumnHandle>(L, ColumnHandle::TypeName, 1);
+    S2D_ASSERT(column, "Not a column");
+    CHECK_EPOCH(*column);
+
+    lua_pushnumber(STATE, (Lua::Number)column->count);
+    return 1;
+}
+
+Column::Column() : Base("Column",
+    {
+        { "__index", Column::index  },
+        { "__len",   Column::length }
+    })
+{   }
+
+#undef CHECK_EPOCH
+
+}
@@ -4,6 +4,8 @@
 
 #include "../../Lua/Lua.cpp"
 
+#include <algorithm>
+
 namespace S2D::Engine
 {
 
@@ -14,9 +16,63 @@ int Time::deltaTime(Lua::State L)
     return 1;
 }
 
+int Time::frameTime(Lua::State L)
+{
+    S2D_ASSERT(!lua_gettop(STATE), "Lua argument size mismatch");
+    lua_pushnumber(STATE, (Lua::Number)frame_dt);
+    return 1;
+}
+
+int Time::tickRate(Lua::State L)
+{
+    S2D_ASSERT(!lua_gettop(STATE), "Lua argument size mismatch");
+    lua_pushnumber(STATE, (Lua::Number)tick_rate);
+    return 1;
+}
+
+int Time::renderRate(Lua::State L)
+{
+    S2D_ASSERT(!lua_gettop(STATE), "Lua argument size mismatch");
+    lua_pushnumber(STATE, (Lua::Number)(frame_dt > 0.0 ? 1.0 / frame_dt : 0.0));
+    return 1;
+}
+
+int Time::setTickRate(Lua::State L)
+{
+    const int args = lua_gettop(STATE);
+    S2D_ASSERT(args == 1 || args == 2, "Lua argument size mismatch");
+    S2D_ASSERT(lua_type(STATE, 1) == LUA_TNUMBER, "Type mismatch");
+
+    const auto rate = lua_tonumber(STATE, 1);
+    S2D_ASSERT(rate > 0, "Tick rate has to be positive");
+    tick_rate = rate;
+
+    // Optionally the most ticks a frame can catch up on
+    if (args == 2)
+    {
+        S2D_ASSERT(lua_type(STATE, 2) == LUA_TNUMBER, "Type mismatch");
+        max_substeps = (uint32_t)std::max(1, (int)lua_tonumber(STATE, 2));
+    }
+
+    lua_settop(STATE, 0);
+    return 0;
+}
+
+int Time::alpha(Lua::State L)
+{
+    S2D_ASSERT(!lua_gettop(STATE), "Lua argument size mismatch");
+    lua_pushnumber(STATE, (Lua::Number)interpolation);
+    return 1;
+}
+
 Time::Time() : Base("Time",
     {
-        { "deltaTime", Time::deltaTime }
+        { "deltaTime",   Time::deltaTime   },
+        { "frameTime",   Time::frameTime   },
+        { "tickRate",    Time::tickRate    },
+        { "renderRate",  Time::renderRate  },
+        { "setTickRate", Time::setTickRate },
+        { "alpha",       Time::alpha       }
     })
 {   }
 
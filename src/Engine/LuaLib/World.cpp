@@ -1,71 +1,100 @@
 #include <Simple2D/Engine/LuaLib/World.hpp>
 #include <Simple2D/Engine/LuaLib/Entity.hpp>
 
+#include <Simple2D/Engine/Commands.hpp>
 #include <Simple2D/Engine/Components.hpp>
+#include <Simple2D/Engine/Prefabs.hpp>
+#include <Simple2D/Engine/Schema.hpp>
 #include <Simple2D/Def.hpp>
 
 #include "../../Lua/Lua.cpp"
 
 #include <flecs.h>
 
+namespace S2D::Lua::CompileTime
+{
+    bool
+    TypeMap<Engine::WorldHandle>::check(State L)
+    {
+        return toUserdata<Engine::WorldHandle>(L, Engine::WorldHandle::TypeName);
+    }
+
+    void
+    TypeMap<Engine::WorldHandle>::push(State L, const Engine::WorldHandle& val)
+    {
+        // There is only ever one world per runtime
+        pushCachedUserdata(L, Engine::WorldHandle::TypeName, 0, val);
+    }
+
+    Engine::WorldHandle
+    TypeMap<Engine::WorldHandle>::construct(State L)
+    {
+        return *toUserdata<Engine::WorldHandle>(L, Engine::WorldHandle::TypeName);
+    }
+}
+
 namespace S2D::Engine
 {
 
+static thread_local flecs::world_t* current_stage = nullptr;
+
+flecs::world_t* stage(flecs::world_t* world)
+{
+    return (current_stage ? current_stage : world);
+}
+
+void setStage(flecs::world_t* stage)
+{
+    current_stage = stage;
+}
+
 static int createEntityFromComponents(Lua::State L)
 {
     using namespace Lua::CompileTime;
-    using namespace Util::CompileTime;
     
-    const std::size_t components = lua_gettop(STATE);
+    const int components = lua_gettop(STATE);
     
-    std::vector<Lua::Table> tables;
-    tables.reserve(components - 1);
+    // The component tables are read in place, the world handle is the first argument
+    lua_pushvalue(STATE, 1);
+    S2D_ASSERT(TypeMap<WorldHandle>::check(L), "Missing world");
+    const auto world_handle = TypeMap<WorldHandle>::construct(L);
+    flecs::world world(stage(world_handle.world));
+    lua_pop(STATE, 1);
 
-    for (uint32_t i = 0; i < components - 1; i++)
+    // Collect the components first so the entity is made in its final table
+    const auto& component_table = componentTable(world_handle.world);
+    std::vector<flecs::id_t> ids;
+    std::vector<const ComponentInfo*> infos;
+    for (int index = 2; index <= components; index++)
     {
-        S2D_ASSERT(TypeMap<Lua::Table>::check(L), "Lua type mismatch");
-        tables.emplace_back(L);
-    }
-
-    Lua::Table world_table(L);
-    flecs::world world((flecs::world_t*)*world_table.get<void**>("world"));
+        S2D_ASSERT(lua_istable(STATE, index), "Lua type mismatch");
+        lua_getfield(STATE, index, "type");
+        const auto component_id = (flecs::id_t)lua_tonumber(STATE, -1);
+        lua_pop(STATE, 1);
 
-    auto entity = world.entity();
+        infos.push_back(component_table.find(component_id));
+        if (infos.back()) ids.push_back(component_id);
+    }
 
-    for (const auto& table : tables)
+    auto entity = createEntity(world, ids);
+    for (int index = 2; index <= components; index++)
     {
-        const std::size_t component_id = table.get<Lua::Number>("type");
+        const auto* info = infos[index - 2];
+        if (!info) continue;
 
-        bool found = false;
-        static_for<(int)Name::Count>([&](auto n)
+        const Lua::TableView table(L, index);
+        if (table.hasValue("value"))
         {
-            if (found) return;
-
-            constexpr std::size_t i = n;
-            constexpr auto component = static_cast<Name>(i);
-            using Data = ComponentData<component>;
-            const std::size_t this_component_id = world.component<Data>().raw_id();
-            if (this_component_id == component_id)
-            {
-                // Found the component
-                found = true;
-
-                Data data;
-                if (table.hasValue("value"))
-                {
-                    const auto& value = table.get<Lua::Table>("value");
-                    Component<component>::fromTable(value, (void*)&data);
-                }
-                entity.set(data);
-            }
-        });
+            const auto value = table.get<Lua::Table>("value");
+            info->emplace(entity, &value);
+        }
+        else info->emplace(entity, nullptr);
+
+        // Drop the nested tables the view left behind
+        lua_settop(STATE, components);
     }
 
-    auto entity_table = Entity().asTable();
-    entity_table.set("good", true);
-    entity_table.set("entity", (void*)entity.raw_id());
-    entity_table.set("world", (void*)world.c_ptr()); 
-    entity_table.toStack(L);
+    TypeMap<EntityHandle>::push(L, { world_handle.world, entity.raw_id() });
 
     return 1;
 }
@@ -73,7 +102,6 @@ static int createEntityFromComponents(Lua::State L)
 static int createEntityInitComponents(Lua::State L)
 {
     using namespace Lua::CompileTime;
-    using namespace Util::CompileTime;
 
     const std::size_t components = lua_gettop(STATE);
     std::vector<Lua::Number> numbers(components);
@@ -85,38 +113,26 @@ static int createEntityInitComponents(Lua::State L)
     }
     
     S2D_ASSERT(lua_gettop(STATE) == 1, "Argument size mismatch");
-    Lua::Table world_table(L);
-    flecs::world world((flecs::world_t*)*world_table.get<void**>("world"));
-    
-    auto entity = world.entity();
+    S2D_ASSERT(TypeMap<WorldHandle>::check(L), "Missing world");
+    const auto world_handle = TypeMap<WorldHandle>::construct(L);
+    flecs::world world(stage(world_handle.world));
+    lua_pop(STATE, 1);
     
-    for (const auto& id : numbers)
+    const auto& component_table = componentTable(world_handle.world);
+    std::vector<flecs::id_t> ids;
+    std::vector<const ComponentInfo*> infos;
+    for (uint32_t i = 0; i < components - 1; i++)
     {
-        const std::size_t component_id = id;
-
-        bool found = false;
-        static_for<(int)Name::Count>([&](auto n)
-        {
-            if (found) return;
-
-            constexpr std::size_t i = n;
-            constexpr auto component = static_cast<Name>(i);
-            using Data = ComponentData<component>;
-            const std::size_t this_component_id = world.component<Data>().raw_id();
-            if (this_component_id == component_id)
-            {
-                // Found the component
-                found = true;
-                entity.set<Data>({});
-            }
-        });
+        const auto* info = component_table.find((flecs::id_t)numbers[i]);
+        if (!info) continue;
+        ids.push_back((flecs::id_t)numbers[i]);
+        infos.push_back(info);
     }
+
+    auto entity = createEntity(world, ids);
+    for (const auto* info : infos) info->emplace(entity, nullptr);
     
-    auto entity_table = Entity().asTable();
-    entity_table.set("good", true);
-    entity_table.set("entity", (void*)entity.raw_id());
-    entity_table.set("world", (void*)world.c_ptr()); 
-    entity_table.toStack(L);
+    TypeMap<EntityHandle>::push(L, { world_handle.world, entity.raw_id() });
     
     return 1;
 }
@@ -124,7 +140,7 @@ static int createEntityInitComponents(Lua::State L)
 int World::createEntity(Lua::State L)
 {
     const std::size_t components = lua_gettop(STATE);
-    S2D_ASSERT(lua_type(STATE, (int)(-1 * components)) == LUA_TTABLE, "Missing world");
+    S2D_ASSERT(lua_type(STATE, (int)(-1 * components)) == LUA_TUSERDATA, "Missing world");
     
     bool is_tables = true;
     bool is_init   = true;
@@ -143,28 +159,124 @@ int World::createEntity(Lua::State L)
 
 int World::getEntity(Lua::State L)
 {
-    const auto [ world_table, name ] = extractArgs<Lua::Table, Lua::String>(L);
+    const auto [ world_handle, name ] = extractArgs<WorldHandle, Lua::String>(L);
 
-    S2D_ASSERT(world_table.hasValue("world"), "World table is messed up");
-    flecs::world world((flecs::world_t*)*world_table.get<void**>("world"));
+    flecs::world world(stage(world_handle.world));
 
     auto entity = world.lookup(name.c_str());
     S2D_ASSERT(entity.is_alive(), "Entity is dead :(");
-
-    auto ent = Engine::Entity().asTable();
-    ent.set("entity", (void*)entity.raw_id());
-    ent.set("good", true);
-    ent.set("world", (void*)world.c_ptr()); // Currently hacky way to store a pointer (must be considered an int64)
     S2D_ASSERT(!lua_gettop(STATE), "Unknown args");
 
-    ent.toStack(L);
+    Lua::CompileTime::TypeMap<EntityHandle>::push(L, { world_handle.world, entity.raw_id() });
+    return 1;
+}
+
+int World::defineComponent(Lua::State L)
+{
+    const auto [ world_handle, name, schema ] = extractArgs<WorldHandle, Lua::String, Lua::Table>(L);
+    S2D_ASSERT(stage(world_handle.world) == world_handle.world, "Components can't be defined from the parallel phase");
+
+    flecs::world world(world_handle.world);
+    const auto id = Engine::defineComponent(world, name, schema);
+    if (!id)
+    {
+        lua_pushnil(STATE);
+        return 1;
+    }
+
+    // Keep the caller's Component enum in step so it can be used right away
+    lua_getglobal(STATE, "Component");
+    if (lua_istable(STATE, -1))
+    {
+        lua_pushnumber(STATE, (Lua::Number)id);
+        lua_setfield(STATE, -2, name.c_str());
+    }
+    lua_pop(STATE, 1);
+
+    lua_pushnumber(STATE, (Lua::Number)id);
+    return 1;
+}
+
+int World::definePrefab(Lua::State L)
+{
+    const auto [ world_handle, definition ] = extractArgs<WorldHandle, Lua::Table>(L);
+    S2D_ASSERT(stage(world_handle.world) == world_handle.world, "Prefabs can't be defined from the parallel phase");
+
+    flecs::world world(world_handle.world);
+    Lua::CompileTime::TypeMap<Lua::Boolean>::push(L, definePrefab(world, definition) != nullptr);
+    return 1;
+}
+
+int World::spawn(Lua::State L)
+{
+    using namespace Lua::CompileTime;
+
+    const int args = lua_gettop(STATE);
+    S2D_ASSERT(args >= 2 && args <= 4, "Expected world:spawn(prefab [, count [, overrides]])");
+
+    const auto* world_handle = Lua::toUserdata<WorldHandle>(L, WorldHandle::TypeName, 1);
+    S2D_ASSERT(world_handle, "Missing world");
+
+    flecs::world root(world_handle->world);
+    const auto* prefab = findPrefab(root, luaL_checkstring(STATE, 2));
+    S2D_ASSERT(prefab, "Unknown prefab");
+    const auto count = (uint32_t)luaL_optnumber(STATE, 3, 1);
+
+    // Overridden components are owned by every instance, the values are written after the spawn
+    const auto& component_table = componentTable(world_handle->world);
+    std::vector<flecs::id_t> owned;
+    std::vector<std::pair<uint32_t, const ComponentInfo*>> overrides;
+    if (args == 4 && !lua_isnil(STATE, 4))
+    {
+        S2D_ASSERT(lua_istable(STATE, 4), "Overrides should be a list of components");
+        const auto size = (uint32_t)lua_rawlen(STATE, 4);
+        for (uint32_t i = 1; i <= size; i++)
+        {
+            lua_rawgeti(STATE, 4, i);
+            S2D_ASSERT(lua_istable(STATE, -1), "Lua type mismatch");
+            lua_getfield(STATE, -1, "type");
+            const auto component_id = (flecs::id_t)lua_tonumber(STATE, -1);
+            lua_pop(STATE, 2);
+
+            const auto* info = component_table.find(component_id);
+            if (!info) continue;
+            owned.push_back(component_id);
+            overrides.emplace_back(i, info);
+        }
+    }
+
+    flecs::world world(stage(world_handle->world));
+    const auto entities = spawnMany(world, *prefab, count, owned);
+
+    for (std::size_t j = 0; j < overrides.size(); j++)
+    {
+        const auto [ index, info ] = overrides[j];
+        lua_rawgeti(STATE, 4, index);
+        const Lua::TableView table(L, lua_gettop(STATE));
+        if (table.hasValue("value"))
+        {
+            const auto value = table.get<Lua::Table>("value");
+            for (const auto e : entities) info->fromView(value, flecs::entity(world, e).get_mut(owned[j]));
+        }
+        lua_settop(STATE, args);
+    }
+
+    lua_createtable(STATE, (int)entities.size(), 0);
+    for (std::size_t i = 0; i < entities.size(); i++)
+    {
+        TypeMap<EntityHandle>::push(L, { world_handle->world, entities[i] });
+        lua_rawseti(STATE, -2, (int)i + 1);
+    }
     return 1;
 }
 
 World::World() : Lua::Lib::Base("World",
     {
-        { "createEntity", World::createEntity },
-        { "getEntity",    World::getEntity    }
+        { "createEntity",    World::createEntity    },
+        { "getEntity",       World::getEntity       },
+        { "defineComponent", World::defineComponent },
+        { "definePrefab",    World::definePrefab    },
+        { "spawn",           World::spawn           }
     })
 {   }
 
@@ -1,5 +1,8 @@
 #include <Simple2D/Engine/LuaScene.hpp>
 
+#include <Simple2D/Engine/Prefabs.hpp>
+#include <Simple2D/Engine/Schema.hpp>
+
 #include <Simple2D/Log/Log.hpp>
 
 namespace S2D::Engine
@@ -12,20 +15,18 @@ LuaScene::LuaScene(const std::string& config_file) :
 void 
 LuaScene::load_entities(const Lua::Table& entities)
 {
-    uint32_t i = 1;
-    while (entities.hasValue(std::to_string(i)))
+    for (uint32_t i = 1; i <= entities.size(); i++)
     {
-        const auto& entity_table = entities.get<Lua::Table>(std::to_string(i++));
+        const auto& entity_table = entities.get<Lua::Table>(i);
         auto entity = (entity_table.hasValue("name")?world.entity(entity_table.get<Lua::String>("name").c_str()):world.entity());
 
         if (entity_table.hasValue("components"))
         {
             const auto& components = entity_table.get<Lua::Table>("components");
 
-            uint32_t j = 1;
-            while (components.hasValue(std::to_string(j)))
+            for (uint32_t j = 1; j <= components.size(); j++)
             {
-                const auto& component_table = components.get<Lua::Table>(std::to_string(j++));
+                const auto& component_table = components.get<Lua::Table>(j);
                 const auto  id = (flecs::id_t)component_table.get<Lua::Number>("type");
                 const auto& value = component_table.get<Lua::Table>("value");
                 entity.add(id);
@@ -39,21 +40,49 @@ LuaScene::load_entities(const Lua::Table& entities)
         {
             const auto& scripts = entity_table.get<Lua::Table>("scripts");
 
-            uint32_t j = 1;
-            while (scripts.hasValue(std::to_string(j)))
+            for (uint32_t j = 1; j <= scripts.size(); j++)
             {
                 // Check if its a string (just load it) or a table (which has a .filename and a .parameters)
                 // where the .paramters should be the global Parameters = {} object of that runtime
-                const auto& script_name = scripts.get<Lua::String>(std::to_string(j++));
+                const auto& script_name = scripts.get<Lua::String>(j);
 
                 if (!entity.has<Engine::Script>()) entity.set<Engine::Script>({});
                 auto* script = entity.get_mut<Engine::Script>();
-                Engine::loadScript(script_name, world, *script);
+                Engine::loadScript(script_name, world, entity, *script);
             }
         }
     }
 }
 
+void
+LuaScene::load_components(const Lua::Table& components)
+{
+    for (const auto& [name, schema] : components.getMap())
+    {
+        const auto* table = std::get_if<std::shared_ptr<Lua::Table>>(&schema.value);
+        if (!table)
+        {
+            Log::Logger::instance("engine")->error("Component '{}' needs a schema table", name);
+            continue;
+        }
+        Engine::defineComponent(world, name, **table);
+    }
+}
+
+void
+LuaScene::load_prefabs(const Lua::Table& prefabs)
+{
+    for (uint32_t i = 1; i <= prefabs.size(); i++)
+        Engine::definePrefab(world, prefabs.get<Lua::Table>(i));
+}
+
+void
+LuaScene::load_systems(const Lua::Table& systems)
+{
+    for (uint32_t i = 1; i <= systems.size(); i++)
+        Engine::loadSystem(systems.get<Lua::String>(i), world);
+}
+
 void 
 LuaScene::load_resources(const Lua::Table& resources)
 {
@@ -108,6 +137,12 @@ LuaScene::start()
 
     prestart();
 
+    // Run the GetComponents function first so the schemas land in the Component table
+    auto comp_res = runtime.runFunction<Lua::Table>("GetComponents");
+    if (comp_res) load_components(std::get<0>(comp_res.value()));
+    else if (!comp_res && comp_res.error().code() != Lua::Runtime::ErrorCode::NotFunction)
+        log->error("In function GetComponents ({}): {}", (int)comp_res.error().code(), comp_res.error().message());
+
     /* Set the Component information */
     Lua::Table globals;
     Engine::registerComponents(globals, world);
@@ -119,6 +154,7 @@ LuaScene::start()
     runtime.setGlobal("Directory", Directory);
 
     Engine::globalEnum<Engine::Projection>(runtime, "ProjectionType");
+    Engine::globalEnum<Engine::ColliderShape>(runtime, "ColliderShape");
 
     // Run the GetResources function and print any errors that occur
     auto res_r = runtime.runFunction<Lua::Table>("GetResources");
@@ -126,12 +162,24 @@ LuaScene::start()
     else if (!res_r && res_r.error().code() != Lua::Runtime::ErrorCode::NotFunction)
         log->error("In function GetResources ({}): {}", (int)res_r.error().code(), res_r.error().message());
 
+    // Run the GetPrefabs function, after the resources since the prefabs can use them
+    auto pre_res = runtime.runFunction<Lua::Table>("GetPrefabs");
+    if (pre_res) load_prefabs(std::get<0>(pre_res.value()));
+    else if (!pre_res && pre_res.error().code() != Lua::Runtime::ErrorCode::NotFunction)
+        log->error("In function GetPrefabs ({}): {}", (int)pre_res.error().code(), pre_res.error().message());
+
     // Run the GetEntities function and print any errors that occur
     auto ent_res = runtime.runFunction<Lua::Table>("GetEntities");
     if (ent_res) load_entities(std::get<0>(ent_res.value()));
     else if (!ent_res && ent_res.error().code() != Lua::Runtime::ErrorCode::NotFunction)
         log->error("In function GetEntities ({}): {}", (int)ent_res.error().code(), ent_res.error().message());
 
+    // Run the GetSystems function and load each system script it lists
+    auto sys_res = runtime.runFunction<Lua::Table>("GetSystems");
+    if (sys_res) load_systems(std::get<0>(sys_res.value()));
+    else if (!sys_res && sys_res.error().code() != Lua::Runtime::ErrorCode::NotFunction)
+        log->error("In function GetSystems ({}): {}", (int)sys_res.error().code(), sys_res.error().message());
+
     poststart();
 }
 
@@ -175,6 +175,9 @@ namespace S2D::Engine
             addBox(ptr, sprite->size, { 0, 0, 0 }, scale);
             
             MAKE_COLLISION_MODEL(Sprite, ptr);
+
+            // Let the broadphase know there's a model to make an object from
+            e.modified<Collider>();
         }
     }
 
@@ -183,57 +186,22 @@ namespace S2D::Engine
     {
         REQUIRE(e.has<Tilemap>());
         auto* tilemap = e.get_mut<Tilemap>();
-        auto* collider = (e.has<Collider>()?e.get_mut<Collider>():nullptr);
 
         const auto tilemap_changed = tilemap->tiles.changed;
         tilemap->tiles.changed = false;
 
-        bool build_mesh = false, build_collider = false;
         // If the tilemap has been changed, destroy the mesh and start over
         if (tilemap_changed)
         {
             auto* ptr = tilemap->mesh.release();
             delete ptr;
-
-            build_mesh = true;
-        }
-
-        if (!tilemap->mesh)
-        {
-            // Construct the mesh
-            tilemap->mesh = std::make_unique<RawMesh>();
-            build_mesh = true;
-        }
-
-        // If the tilemap has been changed, destroy the collision mesh and start over
-        if (tilemap_changed)
-        {
-            auto* ptr = collider->mesh.release();
-            delete ptr;
-
-            build_collider = true;
-        }
-
-        if (!collider->mesh)
-        {
-            // Construct the collision mesh
-            collider->mesh = std::make_unique<CollisionMesh>();
-
-            build_collider = true;
         }
 
-        if (!build_collider && !build_mesh) return;
+        // Collisions read the tiles' solid grid directly, only the drawn mesh is built here
+        if (tilemap->mesh && !tilemap_changed) return;
 
-        CollisionFCL* fcl_collision = nullptr;
-        if (build_collider) 
-        {
-            Log::Logger::instance("engine")->info("building tilemap collider");
-            fcl_collision = new CollisionFCL();
-            collider->mesh->fcl_collision_data = std::shared_ptr<void>(
-                (void*)fcl_collision,
-                [](void* ptr) { delete reinterpret_cast<CollisionFCL*>(ptr); }
-            );
-        }
+        // Construct the mesh
+        tilemap->mesh = std::make_unique<RawMesh>();
 
         const auto& map = tilemap->tiles.map;
 
@@ -259,16 +227,13 @@ namespace S2D::Engine
         //tilemap->mesh->vertices.setPrimitiveType(sf::PrimitiveType::Triangles);
         tilemap->mesh->vertices.setDrawType(VertexArray::DrawType::Triangles);
 
-        const auto scale = (e.has<Transform>()?e.get<Transform>()->scale:1.f);
-
         for (const auto& p : map)
         {
             for (const auto& t : p.second.first)
             {
                 // Extract the coordinate info from the key
-                const int32_t mask = 0xFFFF0000;
-                int16_t x = ((t.first & mask) >> 16);
-                int16_t y = (t.first & (~mask));
+                int16_t x, y;
+                Component<Name::Tilemap>::Map::coords(t.first, x, y);
                 const Math::Vec2f position = {
                     x * tilemap->tilesize.x,
                     y * tilemap->tilesize.y
@@ -300,13 +265,6 @@ namespace S2D::Engine
                     0, 1, 2, 2, 3, 0
                 };
 
-                // Possibly... Now we need to push cubes to the collider mesh, not quads
-                if (fcl_collision && p.second.second == Component<Name::Tilemap>::LayerState::Solid)
-                {
-                    // Push quad at this point
-                    addBox(fcl_collision, tilemap->tilesize, { position.x, position.y, 0 }, scale);
-                }
-                
                 // Construct the vertices of the quad
                 for (uint8_t i = 0; i < 4; i++)
                 {
@@ -326,8 +284,5 @@ namespace S2D::Engine
 
         tilemap->mesh->vertices.upload(vertices);
         tilemap->mesh->vertices.uploadIndices(indices);
-
-        REQUIRE(e.has<Collider>());
-        MAKE_COLLISION_MODEL(Tilemap, fcl_collision);
     }
 }
@@ -0,0 +1,143 @@
+#include <Simple2D/Engine/Prefabs.hpp>
+#include <Simple2D/Engine/Commands.hpp>
+#include <Simple2D/Engine/Components.hpp>
+
+#include <Simple2D/Log/Log.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+namespace S2D::Engine
+{
+
+const Prefab*
+findPrefab(flecs::world& world, const std::string& name)
+{
+    if (!world.has<Prefabs>()) return nullptr;
+    const auto& prefabs = world.get<Prefabs>()->prefabs;
+    const auto it = prefabs.find(name);
+    return (it != prefabs.end() ? &it->second : nullptr);
+}
+
+const Prefab*
+definePrefab(flecs::world& world, const Lua::Table& definition)
+{
+    auto& logger = Log::Logger::instance("engine");
+    if (!definition.hasValue("name"))
+    {
+        logger->error("A prefab needs a name");
+        return nullptr;
+    }
+
+    const auto name = definition.get<Lua::String>("name");
+    if (const auto* existing = findPrefab(world, name)) return existing;
+
+    auto entity = world.prefab(name.c_str());
+
+    Prefab prefab;
+    prefab.entity = entity.raw_id();
+
+    const auto& component_table = componentTable(world.c_ptr());
+    definition.try_get<Lua::Table>("components", [&](const Lua::Table& components)
+    {
+        components.each<Lua::Table>([&](uint32_t i, const Lua::Table& component)
+        {
+            const auto  id   = (flecs::id_t)component.get<Lua::Number>("type");
+            const auto* info = component_table.find(id);
+            if (!info)
+            {
+                logger->error("Prefab '{}' has an unknown component ({})", name, id);
+                return;
+            }
+
+            entity.add(id);
+            if (component.hasValue("value"))
+                info->fromTable(component.get<Lua::Table>("value"), entity.get_mut(id));
+        });
+    });
+
+    // The engine writes these for every entity on its own, sharing them would move every instance at once
+    prefab.owned.push_back(world.component<ComponentData<Name::Transform>>().raw_id());
+    prefab.owned.push_back(world.component<ComponentData<Name::Rigidbody>>().raw_id());
+    definition.try_get<Lua::Table>("owned", [&](const Lua::Table& owned)
+    {
+        owned.each<Lua::Number>([&](uint32_t i, const Lua::Number& id)
+        {
+            if (std::find(prefab.owned.begin(), prefab.owned.end(), (flecs::id_t)id) == prefab.owned.end())
+                prefab.owned.push_back((flecs::id_t)id);
+        });
+    });
+
+    // Only the components the prefab has are copied, the others would come out default constructed
+    prefab.owned.erase(std::remove_if(prefab.owned.begin(), prefab.owned.end(),
+        [&](flecs::id_t id) { return !entity.has(id); }), prefab.owned.end());
+    for (const auto id : prefab.owned) entity.override(id);
+
+    definition.try_get<Lua::Table>("scripts", [&](const Lua::Table& scripts)
+    {
+        scripts.each<Lua::String>([&](uint32_t i, const Lua::String& filename)
+            { prefab.scripts.push_back(filename); });
+    });
+
+    if (!world.has<Prefabs>()) world.set<Prefabs>({});
+    auto& prefabs = world.get_mut<Prefabs>()->prefabs;
+    logger->info("Defined prefab '{}' ({} owned components, {} scripts)", name, prefab.owned.size(), prefab.scripts.size());
+    return &prefabs.emplace(name, std::move(prefab)).first->second;
+}
+
+std::vector<flecs::entity_t>
+spawnMany(flecs::world& world, const Prefab& prefab, uint32_t count, const std::vector<flecs::id_t>& owned)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    // The IsA pair brings the prefab's components (and copies of its owned ones) with it
+    std::vector<flecs::id_t> ids = { ecs_pair(EcsIsA, prefab.entity) };
+    for (const auto id : owned)
+        if (std::find(prefab.owned.begin(), prefab.owned.end(), id) == prefab.owned.end())
+            ids.push_back(id);
+
+    std::vector<flecs::entity_t> entities;
+    entities.reserve(count);
+
+    auto* real_world = const_cast<flecs::world_t*>(ecs_get_world(world.c_ptr()));
+    if (real_world != world.c_ptr())
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const auto entity = createEntity(world, ids).raw_id();
+            for (const auto& filename : prefab.scripts) deferScript(real_world, entity, filename);
+            entities.push_back(entity);
+        }
+        return entities;
+    }
+
+    if (!count) return entities;
+
+    // Instances with scripts get the component in the same move, loading only fills it in
+    if (!prefab.scripts.empty()) ids.push_back(world.component<Script>().raw_id());
+
+    ecs_bulk_desc_t desc = {};
+    desc.count = (int32_t)count;
+    const std::size_t id_count = std::min<std::size_t>(ids.size(), FLECS_ID_DESC_MAX - 1);
+    std::copy_n(ids.begin(), id_count, desc.ids);
+
+    // The returned array points into the table, copy it before anything else touches the world
+    const auto* created = ecs_bulk_init(world.c_ptr(), &desc);
+    entities.assign(created, created + count);
+
+    for (const auto e : entities)
+    {
+        flecs::entity entity(world, e);
+        for (std::size_t i = id_count; i < ids.size(); i++) entity.add(ids[i]);
+        for (const auto& filename : prefab.scripts)
+            loadScript(filename, world, entity, *entity.get_mut<Script>());
+    }
+
+    if (!world.has<Prefabs>()) world.set<Prefabs>({});
+    auto* prefabs = world.get_mut<Prefabs>();
+    prefabs->spawned    += count;
+    prefabs->spawn_time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count() / 1e3;
+    return entities;
+}
+
+}
@@ -88,11 +88,11 @@ namespace S2D::Engine
         Graphics::Program* shader,
         Graphics::Surface& target)
     {
-        const auto* camera_transform = camera.get<Transform>();
-        const auto* entity_transform = entity.get<Transform>();
-        S2D_ASSERT(camera_transform, "Camera missing transform");
+        S2D_ASSERT(camera.has<Transform>(), "Camera missing transform");
 
-        const auto model = modelTransform(entity_transform);
+        // Drawn between the last two ticks, see Time
+        const auto entity_transform = interpolatedTransform(entity);
+        const auto model = modelTransform(&entity_transform);
         const auto view  = viewMatrix(camera);
         const auto proj  = projectionMatrix(camera);
 
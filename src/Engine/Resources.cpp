@@ -4,6 +4,7 @@
 #include <Simple2D/Graphics/Font.hpp>
 
 #include <Simple2D/Log/Log.hpp>
+#include <Simple2D/Engine/HotReload.hpp>
 
 #include <fstream>
 #include <sstream>
@@ -76,9 +77,49 @@ Resources::loadResource<Graphics::Program>(const std::string& name, const std::s
 
     if (res->ready()) res->link();
 
+    shader_sources[name][type] = filename;
+#   ifdef LUA_HOT_RELOAD
+    HotReload::instance().watch(filename);
+#   endif
+
     return { };
 }
 
+uint32_t
+Resources::reloadShaders(const std::filesystem::path& filename)
+{
+    uint32_t count = 0;
+    for (const auto& [name, sources] : shader_sources)
+    {
+        bool uses_file = false;
+        for (const auto& source : sources)
+            if (std::filesystem::weakly_canonical(source.second) == filename) uses_file = true;
+        if (!uses_file) continue;
+
+        auto program = getResource<Graphics::Program>(name);
+        if (!program) continue;
+
+        std::unordered_map<Graphics::Shader::Type, std::string> contents;
+        for (const auto& [type, source] : sources)
+        {
+            std::ifstream file(source);
+            std::stringstream ss;
+            ss << file.rdbuf();
+            contents[type] = ss.str();
+        }
+
+        const auto res = program.value()->reload(contents);
+        if (!res)
+        {
+            Log::Logger::instance("engine")->error("Error reloading shader \"{}\": {}", name, res.error().message());
+            continue;
+        }
+        count++;
+    }
+
+    return count;
+}
+
 template<>
 Resources::Result<void>
 Resources::loadResource<Graphics::DrawTexture>(const std::string& name)
@@ -0,0 +1,192 @@
+#include <Simple2D/Engine/Schema.hpp>
+
+#include <Simple2D/Log/Log.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace S2D::Engine
+{
+
+/* Reading and writing the packed data through its layout */
+static Lua::Table
+fieldsTable(const std::vector<Field>& fields, const char* data)
+{
+    Lua::Table table;
+    for (const auto& field : fields)
+    {
+        const char* ptr = data + field.offset;
+        switch (field.type)
+        {
+        case Field::Type::Number:  table.set(field.name, *reinterpret_cast<const Lua::Number*>(ptr));  break;
+        case Field::Type::Boolean: table.set(field.name, *reinterpret_cast<const Lua::Boolean*>(ptr)); break;
+        case Field::Type::Struct:  table.set(field.name, fieldsTable(field.fields, ptr));              break;
+        default: break;
+        }
+    }
+    return table;
+}
+
+// Keys missing from the table keep their current value
+template<typename TableType>
+static void
+readFields(const std::vector<Field>& fields, const TableType& table, char* data)
+{
+    for (const auto& field : fields)
+    {
+        if (!table.hasValue(field.name)) continue;
+
+        char* ptr = data + field.offset;
+        switch (field.type)
+        {
+        case Field::Type::Number:  *reinterpret_cast<Lua::Number*>(ptr)  = table.template get<Lua::Number>(field.name);  break;
+        case Field::Type::Boolean: *reinterpret_cast<Lua::Boolean*>(ptr) = table.template get<Lua::Boolean>(field.name); break;
+        case Field::Type::Struct:  readFields(field.fields, table.template get<Lua::Table>(field.name), ptr);             break;
+        default: break;
+        }
+    }
+}
+
+// Components without hooks aren't initialized by flecs, schemas start out zeroed
+static void
+zeroComponent(void* ptr, int32_t count, const ecs_type_info_t* type_info)
+{
+    std::memset(ptr, 0, (std::size_t)count * (std::size_t)type_info->size);
+}
+
+static ComponentInfo
+schemaComponentInfo(const ComponentSchema* schema)
+{
+    const Field* layout = &schema->layout;
+    const flecs::id_t id = schema->id;
+
+    ComponentInfo info;
+    info.name   = schema->name.c_str();
+    info.size   = schema->size;
+    info.layout = layout;
+
+    info.getTable = [layout](const void* data) { return fieldsTable(layout->fields, static_cast<const char*>(data)); };
+    info.push     = [layout](Lua::State L, const void* data) { fieldsTable(layout->fields, static_cast<const char*>(data)).toStack(L); };
+
+    info.fromTable = [layout](const Lua::Table& table, void* data)     { readFields(layout->fields, table, static_cast<char*>(data)); };
+    info.fromView  = [layout](const Lua::TableView& table, void* data) { readFields(layout->fields, table, static_cast<char*>(data)); };
+
+    info.emplace = [layout, id](flecs::entity entity, const Lua::TableView* table)
+    {
+        entity.add(id);
+        if (table) readFields(layout->fields, *table, static_cast<char*>(entity.get_mut(id)));
+    };
+
+    return info;
+}
+
+const ComponentSchema*
+findSchema(flecs::world& world, const std::string& name)
+{
+    if (!world.has<ComponentSchemas>()) return nullptr;
+    for (const auto& schema : world.get<ComponentSchemas>()->schemas)
+        if (schema->name == name) return schema.get();
+    return nullptr;
+}
+
+flecs::id_t
+defineComponent(flecs::world& world, const std::string& name, const Lua::Table& schema)
+{
+    auto& logger = Log::Logger::instance("engine");
+
+    if (const auto* existing = findSchema(world, name)) return existing->id;
+    if (world.lookup(name.c_str()))
+    {
+        logger->error("Can't define component '{}', the name is already taken", name);
+        return 0;
+    }
+
+    auto component = std::make_unique<ComponentSchema>();
+    component->name = name;
+
+    // Numbers (and the vectors made of them) go first so the booleans don't leave holes
+    struct Declared { std::string name; std::string type; };
+    std::vector<Declared> declared;
+    for (const auto& [key, value] : schema.getMap())
+    {
+        const auto* type = std::get_if<Lua::String>(&value.value);
+        if (!type)
+        {
+            logger->error("Field '{}' of component '{}' needs a type name", key, name);
+            return 0;
+        }
+        declared.push_back({ key, *type });
+    }
+    std::sort(declared.begin(), declared.end(), [](const Declared& a, const Declared& b)
+    {
+        const bool a_bool = (a.type == "bool"), b_bool = (b.type == "bool");
+        return (a_bool != b_bool ? b_bool : a.name < b.name);
+    });
+
+    std::size_t offset = 0;
+    std::vector<Field> fields;
+    for (const auto& field : declared)
+    {
+        const char* field_name = component->names.emplace_back(field.name).c_str();
+        if (field.type == "number")
+        {
+            fields.push_back({ field_name, offset, Field::Type::Number });
+            offset += sizeof(Lua::Number);
+        }
+        else if (field.type == "bool")
+        {
+            fields.push_back({ field_name, offset, Field::Type::Boolean });
+            offset += sizeof(Lua::Boolean);
+        }
+        else if (field.type == "vec2" || field.type == "vec3")
+        {
+            static const char* axes[] = { "x", "y", "z" };
+            const uint32_t count = (field.type == "vec2" ? 2 : 3);
+
+            Field vector = { field_name, offset, Field::Type::Struct };
+            for (uint32_t i = 0; i < count; i++)
+                vector.fields.push_back({ axes[i], i * sizeof(Lua::Number), Field::Type::Number });
+            fields.push_back(std::move(vector));
+            offset += count * sizeof(Lua::Number);
+        }
+        else
+        {
+            logger->error("Field '{}' of component '{}' has unknown type '{}'", field.name, name, field.type);
+            return 0;
+        }
+    }
+
+    if (fields.empty())
+    {
+        logger->error("Component '{}' needs at least one field", name);
+        return 0;
+    }
+
+    constexpr std::size_t alignment = alignof(Lua::Number);
+    component->size   = (offset + alignment - 1) / alignment * alignment;
+    component->layout = { component->name.c_str(), 0, Field::Type::Struct, std::move(fields) };
+
+    ecs_entity_desc_t entity_desc = {};
+    entity_desc.name = name.c_str();
+
+    ecs_component_desc_t component_desc = {};
+    component_desc.entity         = ecs_entity_init(world.c_ptr(), &entity_desc);
+    component_desc.type.size      = (ecs_size_t)component->size;
+    component_desc.type.alignment = (ecs_size_t)alignment;
+    component->id = ecs_component_init(world.c_ptr(), &component_desc);
+
+    ecs_type_hooks_t hooks = {};
+    hooks.ctor = zeroComponent;
+    ecs_set_hooks_id(world.c_ptr(), component->id, &hooks);
+
+    registerComponent(world.c_ptr(), component->id, schemaComponentInfo(component.get()));
+
+    if (!world.has<ComponentSchemas>()) world.set<ComponentSchemas>({});
+    world.get_mut<ComponentSchemas>()->schemas.push_back(std::move(component));
+
+    const auto& defined = *world.get<ComponentSchemas>()->schemas.back();
+    logger->info("Defined component '{}' ({} bytes, {} fields)", defined.name, defined.size, defined.layout.fields.size());
+    return defined.id;
+}
+
+}
@@ -0,0 +1,166 @@
+#include <Simple2D/Engine/Shapes.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace S2D::Engine
+{
+
+using S2D::Math::Vec2f;
+
+static float cross(const Vec2f& a, const Vec2f& b)
+{
+    return a.x * b.y - a.y * b.x;
+}
+
+Shape2D
+makeShape(
+    ColliderShape shape,
+    Vec2f size,
+    float radius,
+    const std::vector<Vec2f>& points,
+    Vec2f position,
+    float rotation,
+    float scale)
+{
+    const float angle = rotation * 3.14159265f / 180.f;
+    const float c = std::cos(angle), s = std::sin(angle);
+    const auto place = [&](const Vec2f& point)
+    {
+        const auto p = point * scale;
+        return Vec2f(p.x * c - p.y * s + position.x, p.x * s + p.y * c + position.y);
+    };
+
+    Shape2D out;
+    switch (shape)
+    {
+    case ColliderShape::Box:
+    {
+        const auto half = size * 0.5f;
+        out.points = { place({ -half.x, -half.y }), place({ half.x, -half.y }), place({ half.x, half.y }), place({ -half.x, half.y }) };
+        break;
+    }
+    case ColliderShape::Circle:
+        out.points = { place({ 0.f, 0.f }) };
+        out.radius = radius * scale;
+        break;
+    case ColliderShape::Capsule:
+        out.points = { place({ -size.x * 0.5f, 0.f }), place({ size.x * 0.5f, 0.f }) };
+        out.radius = radius * scale;
+        break;
+    case ColliderShape::Polygon:
+    {
+        for (const auto& point : points) out.points.push_back(place(point));
+
+        // The edge normals only point out when the corners go counter-clockwise
+        float area = 0.f;
+        for (std::size_t i = 0; i < out.points.size(); i++)
+            area += cross(out.points[i], out.points[(i + 1) % out.points.size()]);
+        if (area < 0.f) std::reverse(out.points.begin(), out.points.end());
+        break;
+    }
+    default: break;
+    }
+
+    if (out.points.empty()) return out;
+
+    out.min = out.max = out.points[0];
+    for (const auto& point : out.points)
+    {
+        out.min = { std::min(out.min.x, point.x), std::min(out.min.y, point.y) };
+        out.max = { std::max(out.max.x, point.x), std::max(out.max.y, point.y) };
+    }
+    out.min = out.min - Vec2f(out.radius, out.radius);
+    out.max = out.max + Vec2f(out.radius, out.radius);
+    return out;
+}
+
+static void project(const Shape2D& shape, const Vec2f& axis, float& min, float& max)
+{
+    min =  std::numeric_limits<float>::max();
+    max = -std::numeric_limits<float>::max();
+    for (const auto& point : shape.points)
+    {
+        const float d = point.dot(axis);
+        min = std::min(min, d);
+        max = std::max(max, d);
+    }
+    min -= shape.radius;
+    max += shape.radius;
+}
+
+bool
+collideShapes(const Shape2D& a, const Shape2D& b, Manifold& manifold)
+{
+    if (a.points.empty() || b.points.empty()) return false;
+    if (a.max.x < b.min.x || b.max.x < a.min.x || a.max.y < b.min.y || b.max.y < a.min.y) return false;
+
+    float depth = std::numeric_limits<float>::max();
+    Vec2f normal(0.f, 1.f);
+
+    // False as soon as an axis separates them, otherwise keeps the one they overlap least on
+    const auto test = [&](const Vec2f& axis)
+    {
+        float a_min, a_max, b_min, b_max;
+        project(a, axis, a_min, a_max);
+        project(b, axis, b_min, b_max);
+
+        const float forward  = a_max - b_min; // b is ahead of a along the axis
+        const float backward = b_max - a_min;
+        const float overlap  = std::min(forward, backward);
+        if (overlap <= 0.f) return false;
+
+        if (overlap < depth)
+        {
+            depth  = overlap;
+            normal = (forward < backward ? axis : axis * -1.f);
+        }
+        return true;
+    };
+
+    // The edge normals of both shapes, a capsule's segment has one
+    for (const auto* shape : { &a, &b })
+    {
+        const auto& points = shape->points;
+        const std::size_t edges = (points.size() > 2 ? points.size() : points.size() - 1);
+        for (std::size_t i = 0; i < edges; i++)
+        {
+            const auto edge = points[(i + 1) % points.size()] - points[i];
+            if (edge.length() <= 1e-6f) continue;
+            if (!test(Vec2f(edge.y, -edge.x).normalized())) return false;
+        }
+    }
+
+    // Rounded shapes can also be closest corner to corner
+    if (a.radius > 0.f || b.radius > 0.f)
+    {
+        for (const auto& pa : a.points)
+            for (const auto& pb : b.points)
+            {
+                const auto d = pb - pa;
+                if (d.length() > 1e-6f && !test(d.normalized())) return false;
+            }
+    }
+
+    // Two circles on the same spot
+    if (depth == std::numeric_limits<float>::max() && !test(normal)) return false;
+
+    manifold.normal = normal;
+    manifold.depth  = depth;
+
+    // The contacts are b's deepest points, a face touching gives two
+    float deepest = std::numeric_limits<float>::max();
+    for (const auto& point : b.points) deepest = std::min(deepest, point.dot(normal));
+
+    manifold.count = 0;
+    for (const auto& point : b.points)
+    {
+        if (point.dot(normal) > deepest + 1e-3f) continue;
+        manifold.points[manifold.count++] = point - normal * b.radius;
+        if (manifold.count == 2) break;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,60 @@
+#include <Simple2D/Engine/ThreadPool.hpp>
+
+namespace S2D::Engine
+{
+
+ThreadPool::ThreadPool(uint32_t count)
+{
+    for (uint32_t i = 1; i < count; i++)
+        _threads.emplace_back(&ThreadPool::_work, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::scoped_lock lock(_mutex);
+        _quit = true;
+    }
+    _start.notify_all();
+    for (auto& thread : _threads) thread.join();
+}
+
+void ThreadPool::run(const std::function<void(uint32_t)>& job)
+{
+    {
+        std::scoped_lock lock(_mutex);
+        _job = &job;
+        _remaining = _threads.size();
+        _generation++;
+    }
+    _start.notify_all();
+
+    job(0);
+
+    std::unique_lock lock(_mutex);
+    _done.wait(lock, [&]() { return !_remaining; });
+    _job = nullptr;
+}
+
+void ThreadPool::_work(uint32_t index)
+{
+    uint64_t generation = 0;
+    for (;;)
+    {
+        const std::function<void(uint32_t)>* job = nullptr;
+        {
+            std::unique_lock lock(_mutex);
+            _start.wait(lock, [&]() { return _quit || _generation != generation; });
+            if (_quit) return;
+            generation = _generation;
+            job = _job;
+        }
+
+        (*job)(index);
+
+        std::scoped_lock lock(_mutex);
+        if (!--_remaining) _done.notify_one();
+    }
+}
+
+}
@@ -152,6 +152,29 @@ Util::Result<void> Program::link()
     return { };
 }
 
+Util::Result<void> Program::reload(const std::unordered_map<Shader::Type, std::string>& sources)
+{
+    Program program;
+    for (const auto& [type, contents] : sources)
+        if (!program.fromString(contents, type))
+            return { { 0, program.shaders.at(type)->error.value() } };
+
+    // Program doesn't own its handle, a failed link has to give it back here
+    const auto res = program.link();
+    if (!res)
+    {
+        if (program.handle) glDeleteProgram(program.handle);
+        return { { res.error().code(), res.error().message() } };
+    }
+
+    if (_linked && handle) glDeleteProgram(handle);
+    handle  = program.handle;
+    _linked = true;
+    uniforms.clear();
+
+    return { };
+}
+
 void Program::use() const
 {
     S2D_ASSERT(_linked, "Program not linked");
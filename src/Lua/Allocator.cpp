@@ -0,0 +1,168 @@
+#include <Simple2D/Lua/Allocator.hpp>
+
+#include "Lua.cpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace S2D::Lua
+{
+
+void* Allocator::alloc(void* ud, void* ptr, std::size_t osize, std::size_t nsize)
+{
+    auto* allocator = static_cast<Allocator*>(ud);
+
+    // Lua passes the object type as osize when ptr is null
+    if (!ptr) osize = 0;
+
+    if (!nsize)
+    {
+        if (ptr) allocator->_free(ptr, osize);
+        return nullptr;
+    }
+
+    if (!ptr) return allocator->_allocate(nsize);
+
+    // Both sizes in the same class, the block already fits
+    if (osize <= MaxSize && nsize <= MaxSize && _class(osize) == _class(nsize))
+    {
+        allocator->_stats.live += nsize;
+        allocator->_stats.live -= osize;
+        if (allocator->_stats.live > allocator->_stats.peak) allocator->_stats.peak = allocator->_stats.live;
+        return ptr;
+    }
+
+    // Both too large for the pools, let realloc grow in place if it can
+    if (osize > MaxSize && nsize > MaxSize)
+    {
+        void* block = std::realloc(ptr, nsize);
+        if (!block) return nullptr;
+        allocator->_stats.live += nsize;
+        allocator->_stats.live -= osize;
+        if (allocator->_stats.live > allocator->_stats.peak) allocator->_stats.peak = allocator->_stats.live;
+        return block;
+    }
+
+    void* block = allocator->_allocate(nsize);
+    if (!block) return nullptr;
+    std::memcpy(block, ptr, (osize < nsize ? osize : nsize));
+    allocator->_free(ptr, osize);
+    return block;
+}
+
+void* Allocator::_allocate(std::size_t size)
+{
+    void* block = nullptr;
+    if (size > MaxSize) block = std::malloc(size);
+    else
+    {
+        const auto size_class = _class(size);
+        if (!_free_lists[size_class]) _refill(size_class);
+
+        Block* head = _free_lists[size_class];
+        _free_lists[size_class] = head->next;
+        block = head;
+    }
+    if (!block) return nullptr;
+
+    _stats.allocations++;
+    _stats.live += size;
+    if (_stats.live > _stats.peak) _stats.peak = _stats.live;
+    return block;
+}
+
+void Allocator::_free(void* ptr, std::size_t size)
+{
+    _stats.frees++;
+    _stats.live -= size;
+
+    if (size > MaxSize) 
+    {
+        std::free(ptr);
+        return;
+    }
+
+    const auto size_class = _class(size);
+    auto* block = static_cast<Block*>(ptr);
+    block->next = _free_lists[size_class];
+    _free_lists[size_class] = block;
+}
+
+void Allocator::_refill(std::size_t size_class)
+{
+    const std::size_t block_size = (size_class + 1) * Granularity;
+
+    // Whatever is left of the current arena is too small, hand it to the smaller classes
+    // so it isn't wasted, then start a new arena
+    if (_arena_left < block_size)
+    {
+        while (_arena_left >= Granularity)
+        {
+            const auto leftover = _class(_arena_left < MaxSize ? _arena_left : MaxSize);
+            const std::size_t leftover_size = (leftover + 1) * Granularity;
+            if (leftover_size > _arena_left) break;
+
+            auto* block = reinterpret_cast<Block*>(_arena_ptr);
+            block->next = _free_lists[leftover];
+            _free_lists[leftover] = block;
+            _arena_ptr  += leftover_size;
+            _arena_left -= leftover_size;
+        }
+
+        _arenas.push_back(std::make_unique<char[]>(ArenaSize));
+        _arena_ptr  = _arenas.back().get();
+        _arena_left = ArenaSize;
+        _stats.reserved += ArenaSize;
+    }
+
+    // Carve a handful of blocks at a time so a class that is used once doesn't take a whole arena
+    const std::size_t count = std::min<std::size_t>(_arena_left / block_size, 32);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        auto* block = reinterpret_cast<Block*>(_arena_ptr);
+        block->next = _free_lists[size_class];
+        _free_lists[size_class] = block;
+        _arena_ptr  += block_size;
+        _arena_left -= block_size;
+    }
+}
+
+}
+
+namespace S2D::Lua::Lib
+{
+
+int Memory::stats(Lua::State L)
+{
+    S2D_ASSERT(!lua_gettop(STATE), "Lua argument size mismatch");
+
+    void* ud = nullptr;
+    const auto allocf = lua_getallocf(STATE, &ud);
+
+    lua_createtable(STATE, 0, 5);
+    if (allocf == Allocator::alloc)
+    {
+        const auto& stats = static_cast<const Allocator*>(ud)->stats();
+        lua_pushnumber(STATE, (Lua::Number)stats.live);        lua_setfield(STATE, -2, "live");
+        lua_pushnumber(STATE, (Lua::Number)stats.peak);        lua_setfield(STATE, -2, "peak");
+        lua_pushnumber(STATE, (Lua::Number)stats.reserved);    lua_setfield(STATE, -2, "reserved");
+        lua_pushnumber(STATE, (Lua::Number)stats.allocations); lua_setfield(STATE, -2, "allocations");
+        lua_pushnumber(STATE, (Lua::Number)stats.frees);       lua_setfield(STATE, -2, "frees");
+    }
+    else
+    {
+        // The state uses the default allocator, only the collector's count is known
+        const auto live = (std::size_t)lua_gc(STATE, LUA_GCCOUNT, 0) * 1024 + lua_gc(STATE, LUA_GCCOUNTB, 0);
+        lua_pushnumber(STATE, (Lua::Number)live); lua_setfield(STATE, -2, "live");
+    }
+    return 1;
+}
+
+Memory::Memory() : Base("Memory",
+    {
+        { "stats", Memory::stats }
+    })
+{   }
+
+}
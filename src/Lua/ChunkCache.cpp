@@ -0,0 +1,198 @@
+#include <Simple2D/Lua/ChunkCache.hpp>
+
+#include "Lua.cpp"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+int chunk_writer(lua_State* L, const void* data, size_t size, void* chunk)
+{
+    static_cast<std::string*>(chunk)->append(static_cast<const char*>(data), size);
+    return 0;
+}
+
+namespace
+{
+    // Bytecode from LuaJIT and PUC Lua can't be mixed, so tag the files with which one wrote them
+#   ifdef S2D_LUAJIT
+    constexpr char Magic[4] = { 'S', '2', 'D', 'J' };
+#   else
+    constexpr char Magic[4] = { 'S', '2', 'D', 'L' };
+#   endif
+
+    // Followed by the script's canonical path, so a hash collision can't hand out another script,
+    // and then the bytecode
+    struct Header
+    {
+        char     magic[4];
+        int64_t  modified;
+        uint64_t size;
+        uint64_t path_size;
+    };
+}
+
+namespace S2D::Lua
+{
+
+ChunkCache& ChunkCache::instance()
+{
+    static ChunkCache cache;
+    return cache;
+}
+
+Util::Result<ChunkCache::Chunk>
+ChunkCache::get(const std::string& filename)
+{
+    std::error_code code;
+    const auto path = std::filesystem::weakly_canonical(filename, code);
+    const auto key  = (code ? filename : path.string());
+
+    Entry entry;
+    entry.modified = std::filesystem::last_write_time(key, code);
+    const bool exists = !code;
+    entry.size = (exists ? std::filesystem::file_size(key, code) : 0);
+
+    if (exists)
+    {
+        std::scoped_lock lock(_mutex);
+        const auto it = _entries.find(key);
+        if (it != _entries.end() && it->second.modified == entry.modified && it->second.size == entry.size)
+        {
+            _stats.hits++;
+            return { Chunk(it->second.chunk) };
+        }
+
+        if (_read_disk(key, entry))
+        {
+            _stats.disk_hits++;
+            _entries[key] = entry;
+            return { Chunk(entry.chunk) };
+        }
+    }
+
+    // Compile outside the lock, the watcher thread may be compiling something else
+    lua_State* state = luaL_newstate();
+    const auto status = luaL_loadfile(state, key.c_str());
+    if (status != LUA_OK)
+    {
+        std::string message = lua_tostring(state, -1);
+        lua_close(state);
+        return { { status, message } };
+    }
+
+    std::string chunk;
+#   ifdef S2D_LUAJIT
+    lua_dump(state, chunk_writer, &chunk);
+#   else
+    lua_dump(state, chunk_writer, &chunk, 0);
+#   endif
+    lua_close(state);
+
+    entry.chunk = std::make_shared<const std::string>(std::move(chunk));
+
+    std::scoped_lock lock(_mutex);
+    _stats.misses++;
+    if (exists)
+    {
+        _entries[key] = entry;
+        _write_disk(key, entry);
+    }
+    return { Chunk(entry.chunk) };
+}
+
+void ChunkCache::setDirectory(const std::filesystem::path& directory)
+{
+    std::scoped_lock lock(_mutex);
+    _directory = directory;
+    if (_directory.empty()) return;
+
+    std::error_code code;
+    std::filesystem::create_directories(_directory, code);
+    if (code) _directory.clear();
+}
+
+void ChunkCache::invalidate(const std::filesystem::path& filename)
+{
+    std::error_code code;
+    const auto path = std::filesystem::weakly_canonical(filename, code);
+
+    std::scoped_lock lock(_mutex);
+    _entries.erase(code ? filename.string() : path.string());
+}
+
+void ChunkCache::clear()
+{
+    std::scoped_lock lock(_mutex);
+    _entries.clear();
+}
+
+ChunkCache::Stats ChunkCache::stats() const
+{
+    std::scoped_lock lock(_mutex);
+    return _stats;
+}
+
+std::filesystem::path ChunkCache::_disk_path(const std::string& key) const
+{
+    std::stringstream ss;
+    ss << std::hex << std::hash<std::string>{}(key) << ".luac";
+    return _directory / ss.str();
+}
+
+bool ChunkCache::_read_disk(const std::string& key, Entry& entry) const
+{
+    if (_directory.empty()) return false;
+
+    std::ifstream file(_disk_path(key), std::ios::binary);
+    if (!file) return false;
+
+    Header header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(Header))) return false;
+    if (std::memcmp(header.magic, Magic, sizeof(Magic))
+     || header.modified  != entry.modified.time_since_epoch().count()
+     || header.size      != entry.size
+     || header.path_size != key.size()) 
+        return false;
+
+    std::string path(key.size(), '\0');
+    if (!file.read(path.data(), path.size()) || path != key) return false;
+
+    std::stringstream ss;
+    ss << file.rdbuf();
+    file.close();
+
+    // A truncated or corrupt file is dropped so the caller compiles the source and writes a new one
+    lua_State* state = luaL_newstate();
+    auto chunk        = ss.str();
+    const auto status = luaL_loadbufferx(state, chunk.data(), chunk.size(), key.c_str(), "b");
+    lua_close(state);
+    if (chunk.empty() || status != LUA_OK)
+    {
+        std::error_code code;
+        std::filesystem::remove(_disk_path(key), code);
+        return false;
+    }
+
+    entry.chunk = std::make_shared<const std::string>(std::move(chunk));
+    return true;
+}
+
+void ChunkCache::_write_disk(const std::string& key, const Entry& entry) const
+{
+    if (_directory.empty()) return;
+
+    std::ofstream file(_disk_path(key), std::ios::binary | std::ios::trunc);
+    if (!file) return;
+
+    Header header = { };
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.modified  = entry.modified.time_since_epoch().count();
+    header.size      = entry.size;
+    header.path_size = key.size();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    file.write(key.data(), key.size());
+    file.write(entry.chunk->data(), entry.chunk->size());
+}
+
+}
@@ -12,6 +12,17 @@ void Base::registerFunctions(Lua::Runtime& runtime) const
         runtime.registerFunction(_name, p.first, p.second);
 }
 
+void Base::registerMethods(Lua::Runtime& runtime) const
+{
+    registerMethods(runtime, _name);
+}
+
+void Base::registerMethods(Lua::Runtime& runtime, const std::string& type_name) const
+{
+    for (auto& p : _funcs)
+        runtime.registerMethod(type_name, p.first, p.second);
+}
+
 Lua::Table Base::asTable() const
 {
     Lua::Table table;
@@ -45,6 +56,16 @@ namespace detail
     {
         lua_pop(STATE, n);
     }
+
+    void __pushValue(State L, int index)
+    {
+        lua_pushvalue(STATE, index);
+    }
+
+    bool __isTable(State L, int index)
+    {
+        return lua_istable(STATE, index);
+    }
 }
 
 } // S2D::Lua::Lib
\ No newline at end of file
@@ -5,4 +5,82 @@ extern "C"
 #include <lualib.h>
 }
 
-#define STATE reinterpret_cast<lua_State*>(L)
\ No newline at end of file
+#define STATE reinterpret_cast<lua_State*>(L)
+
+#ifdef S2D_LUAJIT
+
+/* LuaJIT speaks the 5.1 API, these fill in the 5.3 calls used by the runtime. The real 
+   functions are called with their names in parentheses so the macros don't catch them. */
+
+#ifndef LUA_OK
+#define LUA_OK 0
+#endif
+
+inline int lua_absindex(lua_State* L, int index)
+{
+    return (index > 0 || index <= LUA_REGISTRYINDEX ? index : lua_gettop(L) + index + 1);
+}
+
+inline int s2d_lua_getfield(lua_State* L, int index, const char* key)
+{
+    (lua_getfield)(L, index, key);
+    return lua_type(L, -1);
+}
+
+inline int s2d_lua_rawget(lua_State* L, int index)
+{
+    (lua_rawget)(L, index);
+    return lua_type(L, -1);
+}
+
+// Integer keys in 5.1 are ints, larger keys (like entity ids) go through as numbers
+inline int s2d_lua_rawgeti(lua_State* L, int index, long long key)
+{
+    if (key == (int)key) (lua_rawgeti)(L, index, (int)key);
+    else
+    {
+        index = lua_absindex(L, index);
+        lua_pushnumber(L, (lua_Number)key);
+        (lua_rawget)(L, index);
+    }
+    return lua_type(L, -1);
+}
+
+inline void s2d_lua_rawseti(lua_State* L, int index, long long key)
+{
+    if (key == (int)key) (lua_rawseti)(L, index, (int)key);
+    else
+    {
+        index = lua_absindex(L, index);
+        lua_pushnumber(L, (lua_Number)key);
+        lua_insert(L, -2);
+        lua_rawset(L, index);
+    }
+}
+
+#define lua_getfield s2d_lua_getfield
+#define lua_rawget   s2d_lua_rawget
+#define lua_rawgeti  s2d_lua_rawgeti
+#define lua_rawseti  s2d_lua_rawseti
+
+inline size_t lua_rawlen(lua_State* L, int index)
+{
+    return lua_objlen(L, index);
+}
+
+inline int lua_rawgetp(lua_State* L, int index, const void* key)
+{
+    index = lua_absindex(L, index);
+    lua_pushlightuserdata(L, const_cast<void*>(key));
+    return lua_rawget(L, index);
+}
+
+inline void lua_rawsetp(lua_State* L, int index, const void* key)
+{
+    index = lua_absindex(L, index);
+    lua_pushlightuserdata(L, const_cast<void*>(key));
+    lua_insert(L, -2);
+    lua_rawset(L, index);
+}
+
+#endif
@@ -0,0 +1,231 @@
+#include <Simple2D/Lua/Profiler.hpp>
+
+#include "Lua.cpp"
+
+#include <algorithm>
+#include <fstream>
+
+static void profiler_hook(lua_State* L, lua_Debug* debug)
+{
+    S2D::Lua::Profiler::instance().sample(L);
+}
+
+namespace S2D::Lua
+{
+
+Profiler& Profiler::instance()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::~Profiler()
+{
+    _running = false;
+    {
+        std::scoped_lock lock(_samples_mutex);
+        _quit = true;
+    }
+    _wake.notify_one();
+    if (_thread.joinable()) _thread.join();
+}
+
+void Profiler::start(uint32_t instructions)
+{
+    if (_running) return;
+    _instructions = std::max<uint32_t>(instructions, 1);
+
+    {
+        std::scoped_lock lock(_samples_mutex);
+        _quit = false;
+    }
+    if (!_thread.joinable()) _thread = std::thread(&Profiler::_aggregate, this);
+
+    std::scoped_lock lock(_states_mutex);
+    _running = true;
+    for (auto& [L, last] : _states)
+    {
+        lua_sethook(STATE, profiler_hook, LUA_MASKCOUNT, (int)_instructions);
+        last = Clock::now();
+    }
+}
+
+void Profiler::stop()
+{
+    if (!_running) return;
+
+    {
+        std::scoped_lock lock(_states_mutex);
+        _running = false;
+        for (auto& [L, last] : _states)
+            lua_sethook(STATE, nullptr, 0, 0);
+    }
+
+    {
+        std::scoped_lock lock(_samples_mutex);
+        _quit = true;
+    }
+    _wake.notify_one();
+    if (_thread.joinable()) _thread.join();
+}
+
+bool Profiler::dump(const std::filesystem::path& filename)
+{
+    _flush();
+
+    std::ofstream file(filename);
+    if (!file) return false;
+
+    std::scoped_lock lock(_folded_mutex);
+    for (const auto& [stack, nanoseconds] : _folded)
+        file << stack << " " << std::max<uint64_t>(nanoseconds / 1000, 1) << "\n";
+
+    return true;
+}
+
+void Profiler::clear()
+{
+    {
+        std::scoped_lock lock(_samples_mutex);
+        _samples.clear();
+    }
+    std::scoped_lock lock(_folded_mutex);
+    _folded.clear();
+}
+
+void Profiler::attach(State L)
+{
+    std::scoped_lock lock(_states_mutex);
+    _states[L] = Clock::now();
+    if (_running) lua_sethook(STATE, profiler_hook, LUA_MASKCOUNT, (int)_instructions);
+}
+
+void Profiler::detach(State L)
+{
+    std::scoped_lock lock(_states_mutex);
+    _states.erase(L);
+}
+
+void Profiler::enter(State L)
+{
+    // Only time spent inside Lua counts, so restart the clock whenever the engine calls in
+    std::scoped_lock lock(_states_mutex);
+    const auto it = _states.find(L);
+    if (it != _states.end()) it->second = Clock::now();
+}
+
+void Profiler::sample(State L)
+{
+    const auto now = Clock::now();
+    uint64_t nanoseconds = 0;
+    {
+        std::scoped_lock lock(_states_mutex);
+        const auto it = _states.find(L);
+        if (it == _states.end()) return;
+        nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(now - it->second).count();
+        it->second = now;
+    }
+
+    // Walk from the innermost frame out, then fold from the root in
+    std::vector<std::string> frames;
+    lua_Debug debug;
+    for (int level = 0; lua_getstack(STATE, level, &debug); level++)
+    {
+        lua_getinfo(STATE, "Sln", &debug);
+
+        std::string frame = debug.short_src;
+        frame += ':';
+        if (debug.name) frame += debug.name;
+        else if (debug.what && debug.what[0] == 'm') frame += "main chunk";
+        else frame += '?';
+        if (debug.currentline > 0) frame += ':' + std::to_string(debug.currentline);
+
+        frames.push_back(std::move(frame));
+    }
+    if (frames.empty()) return;
+
+    Sample sample{ "", nanoseconds };
+    for (auto it = frames.rbegin(); it != frames.rend(); it++)
+    {
+        if (!sample.stack.empty()) sample.stack += ';';
+        sample.stack += *it;
+    }
+
+    bool wake = false;
+    {
+        std::scoped_lock lock(_samples_mutex);
+        _samples.push_back(std::move(sample));
+        wake = (_samples.size() >= 256);
+    }
+    if (wake) _wake.notify_one();
+}
+
+void Profiler::_aggregate()
+{
+    using namespace std::chrono_literals;
+
+    for (;;)
+    {
+        bool quit = false;
+        {
+            std::unique_lock lock(_samples_mutex);
+            _wake.wait_for(lock, 50ms, [&]() { return _quit || _samples.size() >= 256; });
+            quit = _quit;
+        }
+
+        _flush();
+        if (quit) break;
+    }
+}
+
+void Profiler::_flush()
+{
+    std::vector<Sample> samples;
+    {
+        std::scoped_lock lock(_samples_mutex);
+        samples.swap(_samples);
+    }
+    if (samples.empty()) return;
+
+    std::scoped_lock lock(_folded_mutex);
+    for (auto& sample : samples)
+        _folded[sample.stack] += sample.nanoseconds;
+}
+
+}
+
+namespace S2D::Lua::Lib
+{
+
+int Profiling::start(Lua::State L)
+{
+    // Optional number of instructions between samples
+    const auto instructions = (lua_gettop(STATE) ? (uint32_t)lua_tonumber(STATE, 1) : 10000U);
+    lua_settop(STATE, 0);
+    Profiler::instance().start(instructions);
+    return 0;
+}
+
+int Profiling::stop(Lua::State L)
+{
+    S2D_ASSERT(!lua_gettop(STATE), "Lua argument size mismatch");
+    Profiler::instance().stop();
+    return 0;
+}
+
+int Profiling::dump(Lua::State L)
+{
+    const auto [ filename ] = extractArgs<Lua::String>(L);
+    lua_pushboolean(STATE, Profiler::instance().dump(filename));
+    return 1;
+}
+
+Profiling::Profiling() : Base("Profiler",
+    {
+        { "start", Profiling::start },
+        { "stop",  Profiling::stop  },
+        { "dump",  Profiling::dump  }
+    })
+{   }
+
+}
@@ -17,28 +17,88 @@ bool lua_check(lua_State* L, int r, std::optional<int> line = std::nullopt)
     return true;
 }
 
+int panic(lua_State* L)
+{
+    std::cout << "PANIC: unprotected error in call to Lua API (" << lua_tostring(L, -1) << ")\n";
+    return 0;
+}
+
+lua_State* new_state(S2D::Lua::Allocator* allocator)
+{
+#   ifdef S2D_LUAJIT
+    // 64-bit LuaJIT refuses custom allocators, it needs its own to keep memory in the low range
+    return luaL_newstate();
+#   else
+    lua_State* L = lua_newstate(S2D::Lua::Allocator::alloc, allocator);
+    if (L) lua_atpanic(L, panic);
+    return L;
+#   endif
+}
+
 namespace S2D::Lua
 {
 
-Runtime::Runtime(const std::string& filename) :
-    L(luaL_newstate()),
-    _good(lua_check(STATE, luaL_dofile(STATE, filename.c_str()))),
+Runtime::Runtime(const std::string& filename, bool instanced) :
+    _allocator(std::make_unique<Allocator>()),
+    L(new_state(_allocator.get())),
+    _good(false),
+    _instanced(instanced),
     _filename(std::filesystem::path(filename).filename().c_str()),
-    _last_modified(std::filesystem::last_write_time(std::filesystem::path(filename)))
+    _path(std::filesystem::weakly_canonical(filename)),
+    _environments(1, Environment{ LUA_NOREF, {}, 0 })
 {
+    if (L) Profiler::instance().attach(L);
+
+#   ifdef LUA_HOT_RELOAD
+    _last_modified = std::filesystem::last_write_time(_path);
+#   endif
+
+#   ifdef S2D_LUAJIT
+    lua_pushvalue(STATE, LUA_GLOBALSINDEX);
+    _environments[0].table = luaL_ref(STATE, LUA_REGISTRYINDEX);
+#   else
+    _environments[0].table = LUA_RIDX_GLOBALS;
+#   endif
+
+    // Scripts spawned over and over (bullets and such) are only parsed the first time
+    auto chunk = ChunkCache::instance().get(filename);
+    if (chunk)
+    {
+        _chunk = *chunk.value();
+        _good  = lua_check(STATE, luaL_loadbufferx(STATE, _chunk.data(), _chunk.size(), ("@" + filename).c_str(), "b"));
+    }
+    else std::cout << "Message: " << chunk.error().message() << "\n";
+
+    if (good())
+    {
+        // Instances load the kept chunk later, otherwise run it like luaL_dofile would
+        if (instanced) _pop();
+        else _good = lua_check(STATE, lua_pcall(STATE, 0, 0, 0));
+    }
     if (good()) luaL_openlibs(STATE);
 }
 
 Runtime::Runtime(Runtime&& r) :
+    _allocator(std::move(r._allocator)),
     L(r.L),
     _good(r._good),
-    _filename(r._filename)
+    _instanced(r._instanced),
+    _filename(r._filename),
+    _path(r._path),
+    _chunk(std::move(r._chunk)),
+    _function_names(std::move(r._function_names)),
+    _environments(std::move(r._environments)),
+    _free_environments(std::move(r._free_environments))
 {
+#   ifdef LUA_HOT_RELOAD
+    _last_modified = r._last_modified;
+#   endif
     r.L = nullptr;
 }
 
 Runtime::~Runtime()
 {
+    if (L) Profiler::instance().detach(L);
     if (L) lua_close(STATE);
     L = nullptr;
 }
@@ -66,6 +126,253 @@ Runtime::registerFunction(
     return { };
 }
 
+Runtime::Result<void>
+Runtime::registerMethod(
+    const std::string& type_name,
+    const std::string& func_name,
+    Lua::Function func)
+{
+    luaL_newmetatable(STATE, type_name.c_str());
+
+    // Metamethods go straight into the metatable
+    if (!func_name.compare(0, 2, "__"))
+    {
+        lua_pushcfunction(STATE, reinterpret_cast<lua_CFunction>(func));
+        lua_setfield(STATE, -2, func_name.c_str());
+        lua_pop(STATE, 1);
+        return { };
+    }
+
+    if (lua_getfield(STATE, -1, "__index") != LUA_TTABLE)
+    {
+        lua_pop(STATE, 1);
+        lua_newtable(STATE);
+        lua_pushvalue(STATE, -1);
+        lua_setfield(STATE, -3, "__index");
+    }
+
+    lua_pushcfunction(STATE, reinterpret_cast<lua_CFunction>(func));
+    lua_setfield(STATE, -2, func_name.c_str());
+
+    lua_pop(STATE, 2);
+
+    return { };
+}
+
+Runtime::Result<void>
+Runtime::cacheFunction(uint32_t slot, const std::string& name)
+{
+    S2D_ASSERT(slot < MaxFunctionSlots, "Function slot out of range");
+
+    if (_function_names.size() <= slot) _function_names.resize(slot + 1);
+    _function_names[slot] = name;
+
+    for (uint32_t i = 1; i < _environments.size(); i++)
+        if (_environments[i].table != LUA_NOREF) _resolve(_environments[i], slot);
+
+    if (!_resolve(_environments[0], slot)) return { ErrorCode::NotFunction };
+
+    return { };
+}
+
+void
+Runtime::resolveFunctions()
+{
+    for (auto& environment : _environments)
+    {
+        if (environment.table == LUA_NOREF) continue;
+        for (uint32_t slot = 0; slot < _function_names.size(); slot++)
+            _resolve(environment, slot);
+    }
+}
+
+bool
+Runtime::hasFunction(uint32_t slot, Instance instance) const
+{
+    const auto index = (uint32_t)instance;
+    return slot < MaxFunctionSlots && index < _environments.size() && (_environments[index].function_mask & (1U << slot));
+}
+
+Runtime::Result<void>
+Runtime::runString(const std::string& code, const std::string& name)
+{
+    if (luaL_loadbufferx(STATE, code.data(), code.size(), name.c_str(), "t") != LUA_OK || _call_func(0, 0) != LUA_OK)
+    {
+        auto message = CompileTime::TypeMap<Lua::String>::construct(L);
+        _pop();
+        return { { ErrorCode::FunctionError, message } };
+    }
+
+    return { };
+}
+
+Runtime::Result<std::string>
+Runtime::compile(const std::string& filename)
+{
+    auto chunk = ChunkCache::instance().get(filename);
+    if (!chunk) return { { ErrorCode::FunctionError, chunk.error().message() } };
+    return { std::string(*chunk.value()) };
+}
+
+Runtime::Result<void>
+Runtime::reload(const std::string& chunk)
+{
+    if (!L) return { ErrorCode::FunctionError };
+
+    std::optional<std::string> error;
+    for (uint32_t i = (_instanced ? 1 : 0); i < _environments.size(); i++)
+    {
+        if (_environments[i].table == LUA_NOREF) continue;
+        if (!_run_chunk(chunk, _environments[i]) && !error)
+        {
+            error = CompileTime::TypeMap<Lua::String>::construct(L);
+            _pop();
+        }
+    }
+
+    _chunk = chunk;
+    _good  = !error;
+    resolveFunctions();
+
+#   ifdef LUA_HOT_RELOAD
+    std::error_code code;
+    const auto modified = std::filesystem::last_write_time(_path, code);
+    if (!code) _last_modified = modified;
+#   endif
+
+    if (error) return { { ErrorCode::FunctionError, error.value() } };
+    return { };
+}
+
+Runtime::Result<Runtime::Instance>
+Runtime::createInstance()
+{
+    if (!good()) return { ErrorCode::FunctionError };
+
+    // The environment keeps its own writes and reads through to the globals
+    lua_createtable(STATE, 0, 4);
+    if (luaL_newmetatable(STATE, "Runtime.Instance"))
+    {
+        _push_ref(_environments[0].table);
+        lua_setfield(STATE, -2, "__index");
+    }
+    lua_setmetatable(STATE, -2);
+
+    const auto chunk_name = "@" + _filename;
+    if (luaL_loadbufferx(STATE, _chunk.data(), _chunk.size(), chunk_name.c_str(), "b") != LUA_OK)
+    {
+        // The message and the environment under it
+        auto message = CompileTime::TypeMap<Lua::String>::construct(L);
+        _pop(2);
+        return { { ErrorCode::FunctionError, message } };
+    }
+
+    // A freshly loaded chunk has its own _ENV upvalue, so this doesn't touch other instances
+    lua_pushvalue(STATE, -2);
+#   ifdef S2D_LUAJIT
+    lua_setfenv(STATE, -2);
+#   else
+    lua_setupvalue(STATE, -2, 1);
+#   endif
+    if (_call_func(0, 0) != LUA_OK)
+    {
+        // The message and the environment under it
+        auto message = CompileTime::TypeMap<Lua::String>::construct(L);
+        _pop(2);
+        return { { ErrorCode::FunctionError, message } };
+    }
+
+    uint32_t index = _environments.size();
+    if (_free_environments.size())
+    {
+        index = _free_environments.back();
+        _free_environments.pop_back();
+    }
+    else _environments.emplace_back();
+
+    auto& environment = _environments[index];
+    environment = { luaL_ref(STATE, LUA_REGISTRYINDEX), {}, 0 };
+    for (uint32_t slot = 0; slot < _function_names.size(); slot++)
+        _resolve(environment, slot);
+
+    return { (Instance)index };
+}
+
+void
+Runtime::destroyInstance(Instance instance)
+{
+    const auto index = (uint32_t)instance;
+    if (!L || instance == Instance::Global || index >= _environments.size()) return;
+
+    auto& environment = _environments[index];
+    if (environment.table == LUA_NOREF) return;
+
+    for (const auto ref : environment.function_refs)
+        luaL_unref(STATE, LUA_REGISTRYINDEX, ref);
+    luaL_unref(STATE, LUA_REGISTRYINDEX, environment.table);
+
+    environment = { LUA_NOREF, {}, 0 };
+    _free_environments.push_back(index);
+}
+
+Runtime::Result<void>
+Runtime::resetInstance(Instance instance)
+{
+    const auto index = (uint32_t)instance;
+    if (!good() || index >= _environments.size() || _environments[index].table == LUA_NOREF) 
+        return { ErrorCode::VariableDoesntExist };
+
+    auto& environment = _environments[index];
+    if (instance != Instance::Global)
+    {
+        _push_ref(environment.table);
+        lua_pushnil(STATE);
+        while (lua_next(STATE, -2))
+        {
+            // Clearing a field that already exists is allowed during traversal
+            _pop();
+            lua_pushvalue(STATE, -1);
+            lua_pushnil(STATE);
+            lua_rawset(STATE, -4);
+        }
+        _pop();
+    }
+
+    if (!_run_chunk(_chunk, environment, false))
+    {
+        auto message = CompileTime::TypeMap<Lua::String>::construct(L);
+        _pop();
+        return { { ErrorCode::FunctionError, message } };
+    }
+
+    for (uint32_t slot = 0; slot < _function_names.size(); slot++)
+        _resolve(environment, slot);
+
+    return { };
+}
+
+std::size_t
+Runtime::instanceCount() const
+{
+    return _environments.size() - _free_environments.size() - 1;
+}
+
+std::size_t
+Runtime::memoryUsage() const
+{
+    return memoryStats().live;
+}
+
+Allocator::Stats
+Runtime::memoryStats() const
+{
+    if (lua_getallocf(STATE, nullptr) == Allocator::alloc) return _allocator->stats();
+
+    Allocator::Stats stats;
+    stats.live = (std::size_t)lua_gc(STATE, LUA_GCCOUNT, 0) * 1024 + lua_gc(STATE, LUA_GCCOUNTB, 0);
+    return stats;
+}
+
 template<typename T>
 Runtime::Result<T>
 Runtime::getGlobal(const std::string& name)
@@ -82,6 +389,29 @@ template Runtime::Result<String>   Runtime::getGlobal(const std::string&);
 template Runtime::Result<Boolean>  Runtime::getGlobal(const std::string&);
 template Runtime::Result<Table>    Runtime::getGlobal(const std::string&);
 
+template<typename T>
+Runtime::Result<T>
+Runtime::getGlobal(Instance instance, const std::string& name)
+{
+    _push_ref(_environments[(uint32_t)instance].table);
+    lua_getfield(STATE, -1, name.c_str());
+    lua_remove(STATE, -2);
+    if (lua_type(STATE, -1) != CompileTime::TypeMap<T>::LuaType)
+    {
+        _pop();
+        return { ErrorCode::TypeMismatch };
+    }
+
+    // Tables pop themselves when constructed
+    auto value = CompileTime::TypeMap<T>::construct(L);
+    if constexpr (!std::is_same_v<T, Table>) _pop();
+    return { std::move(value) };
+}
+template Runtime::Result<Number>   Runtime::getGlobal(Instance, const std::string&);
+template Runtime::Result<String>   Runtime::getGlobal(Instance, const std::string&);
+template Runtime::Result<Boolean>  Runtime::getGlobal(Instance, const std::string&);
+template Runtime::Result<Table>    Runtime::getGlobal(Instance, const std::string&);
+
 template<>
 Runtime::Result<Lua::Function>
 Runtime::getGlobal<Lua::Function>(const std::string& name)
@@ -121,7 +451,106 @@ void Runtime::_pop(std::size_t n) const
 
 int Runtime::_call_func(uint32_t args, uint32_t ret) const
 {
+    if (Profiler::running()) Profiler::instance().enter(L);
     return lua_pcall(STATE, args, ret, 0);
 }
 
+void Runtime::_push_ref(int ref) const
+{
+    lua_rawgeti(STATE, LUA_REGISTRYINDEX, ref);
+}
+
+bool Runtime::_resolve(Environment& environment, uint32_t slot)
+{
+    if (environment.function_refs.size() <= slot) environment.function_refs.resize(slot + 1, LUA_NOREF);
+    auto& ref = environment.function_refs[slot];
+
+    luaL_unref(STATE, LUA_REGISTRYINDEX, ref);
+    ref = LUA_NOREF;
+    environment.function_mask &= ~(1U << slot);
+
+    if (_function_names[slot].empty()) return false;
+
+    // Raw so an instance doesn't pick up the functions from the global run through __index
+    _push_ref(environment.table);
+    lua_pushstring(STATE, _function_names[slot].c_str());
+    if (lua_rawget(STATE, -2) != LUA_TFUNCTION)
+    {
+        _pop(2);
+        return false;
+    }
+
+    ref = luaL_ref(STATE, LUA_REGISTRYINDEX);
+    _pop();
+    environment.function_mask |= (1U << slot);
+
+    return true;
+}
+
+bool Runtime::_run_chunk(const std::string& chunk, const Environment& environment, bool keep_values)
+{
+    _push_ref(environment.table);
+    const auto table = lua_gettop(STATE);
+
+    // Keep everything that isn't code so the new chunk's top level doesn't reset it
+    lua_newtable(STATE);
+    if (keep_values)
+    {
+        lua_pushnil(STATE);
+        while (lua_next(STATE, table))
+        {
+            if (lua_type(STATE, -1) == LUA_TFUNCTION) { _pop(); continue; }
+            lua_pushvalue(STATE, -2);
+            lua_insert(STATE, -2);
+            lua_rawset(STATE, table + 1);
+        }
+    }
+
+    const auto chunk_name = "@" + _filename;
+    if (luaL_loadbufferx(STATE, chunk.data(), chunk.size(), chunk_name.c_str(), "b") != LUA_OK)
+    {
+        lua_insert(STATE, table);
+        _pop(2);
+        return false;
+    }
+
+    lua_pushvalue(STATE, table);
+#   ifdef S2D_LUAJIT
+    lua_setfenv(STATE, -2);
+#   else
+    lua_setupvalue(STATE, -2, 1);
+#   endif
+
+    const bool ran = (_call_func(0, 0) == LUA_OK);
+
+    // Put the saved values back, even if the chunk failed part way
+    lua_pushnil(STATE);
+    while (lua_next(STATE, table + 1))
+    {
+        lua_pushvalue(STATE, -2);
+        lua_insert(STATE, -2);
+        lua_rawset(STATE, table);
+    }
+
+    if (!ran)
+    {
+        // Leave only the error message
+        lua_insert(STATE, table);
+        _pop(2);
+        return false;
+    }
+
+    _pop(2);
+    return true;
+}
+
+void Runtime::_set_field(Instance instance, const std::string& name)
+{
+    // Value is at the top of the stack
+    _push_ref(_environments[(uint32_t)instance].table);
+    lua_insert(STATE, -2);
+    lua_setfield(STATE, -2, name.c_str());
+    _pop();
+}
+
 } // S2D::Lua
@@ -10,14 +10,90 @@ namespace S2D::Lua
 {
 
 /* Table::Data */
+namespace
+{
+    // Maps the type requested through the public API onto the type held in the variant
+    template<typename T>
+    using Stored = std::conditional_t<
+        std::is_same_v<T, Lua::Table>, 
+        std::shared_ptr<Table>,
+        std::conditional_t<std::is_same_v<T, void**>, void*, T>
+    >;
+
+    template<typename T, typename V>
+    auto& valueOf(V& value)
+    {
+        auto* stored = std::get_if<Stored<T>>(&value);
+        S2D_ASSERT(stored, "Table value type mismatch");
+
+        if constexpr (std::is_same_v<T, Lua::Table>) 
+            return **stored;
+        else if constexpr (std::is_same_v<T, void**>)
+        {
+            // Userdata coming from Lua is stored as the address of the block, which itself
+            // holds the pointer we care about
+            using Ptr = std::conditional_t<std::is_const_v<V>, void** const*, void***>;
+            return *reinterpret_cast<Ptr>(stored);
+        }
+        else return *stored;
+    }
+
+    // Reads the value at the top of the stack and pops it
+    Table::Data dataFromStack(State L)
+    {
+        Table::Data data;
+        data.type = lua_type(STATE, -1);
+
+        const auto count = lua_gettop(STATE);
+        switch(data.type)
+        {
+        case LUA_TNUMBER:   data.value.emplace<Lua::Number> (lua_tonumber(STATE, -1));          break;
+        case LUA_TSTRING:   data.value.emplace<Lua::String> (lua_tostring(STATE, -1));          break;
+        case LUA_TBOOLEAN:  data.value.emplace<Lua::Boolean>(lua_toboolean(STATE, -1));         break;
+        case LUA_TUSERDATA: data.value.emplace<void*>       (lua_touserdata(STATE, -1));        break;
+        case LUA_TTABLE:    data.value.emplace<std::shared_ptr<Table>>(std::make_shared<Table>(L)); break;
+        case LUA_TFUNCTION: data.value.emplace<Lua::Function>((Lua::Function)lua_tocfunction(STATE, -1)); break;
+        }
+
+        if (count == lua_gettop(STATE)) lua_pop(STATE, 1);
+        return data;
+    }
+
+    // Pushes the value onto the stack, returns false if there was nothing to push
+    bool dataToStack(State L, const Table::Data& data)
+    {
+        using namespace CompileTime;
+
+        const auto& value = data.value;
+        if (std::holds_alternative<std::monostate>(value)) return false;
+
+        switch (data.type)
+        {
+        case LUA_TNUMBER:   TypeMap<Lua::Number>  ::push(L, valueOf<Lua::Number>  (value)); break;
+        case LUA_TSTRING:   TypeMap<Lua::String>  ::push(L, valueOf<Lua::String>  (value)); break;
+        case LUA_TBOOLEAN:  TypeMap<Lua::Boolean> ::push(L, valueOf<Lua::Boolean> (value)); break;
+        case LUA_TTABLE:    valueOf<Lua::Table>(value).toStack(L);                           break;
+        case LUA_TFUNCTION: TypeMap<Lua::Function>::push(L, valueOf<Lua::Function>(value)); break;
+        default: TypeMap<void*>::push(L, valueOf<void*>(value)); break; // Worried about this... everywhere else needs void** so why does void* work?
+        }
+        return true;
+    }
+}
+
 template<typename T>
 Table::Data 
 Table::Data::fromValue(const T& value)
 {
-    return Data {
-        .data = emplace(value),
-        .type = CompileTime::TypeMap<T>::LuaType
-    };    
+    if constexpr (std::is_same_v<T, Lua::Table>)
+        return Data {
+            .value = Value(std::in_place_type<std::shared_ptr<Table>>, std::make_shared<Table>(value)),
+            .type  = CompileTime::TypeMap<T>::LuaType
+        };
+    else
+        return Data {
+            .value = Value(std::in_place_type<T>, value),
+            .type  = CompileTime::TypeMap<T>::LuaType
+        };
 }
 template Table::Data Table::Data::fromValue(const Lua::Number&);
 template Table::Data Table::Data::fromValue(const Lua::String&);
@@ -26,23 +102,6 @@ template Table::Data Table::Data::fromValue(const Lua::Function&);
 template Table::Data Table::Data::fromValue(const Lua::Table&);
 template Table::Data Table::Data::fromValue(void* const&);
 
-template<typename T>
-std::shared_ptr<void>
-Table::Data::emplace(const T& value)
-{
-    std::shared_ptr<void> ptr = std::shared_ptr<void>(
-        new T(),
-        [](void* ptr) { delete reinterpret_cast<T*>(ptr); }
-    );
-    *static_cast<T*>(ptr.get()) = value;
-    return ptr;
-}
-template std::shared_ptr<void> Table::Data::emplace(const Lua::Number&);
-template std::shared_ptr<void> Table::Data::emplace(const Lua::String&);
-template std::shared_ptr<void> Table::Data::emplace(const Lua::Boolean&);
-template std::shared_ptr<void> Table::Data::emplace(const Lua::Function&);
-template std::shared_ptr<void> Table::Data::emplace(const Lua::Table&);
-
 /* Table */
 
 Table::Table(const Table::Map& map) :
@@ -51,10 +110,30 @@ Table::Table(const Table::Map& map) :
 
 Table::Table(State L)
 {
+    // Pull the sequence 1..n straight into the array part
+    const auto length = lua_rawlen(STATE, -1);
+    array.reserve(length);
+    for (std::size_t i = 1; i <= length; i++)
+    {
+        lua_rawgeti(STATE, -1, i);
+        array.push_back(dataFromStack(L));
+    }
+
     lua_pushnil(STATE);
     while (lua_next(STATE, -2) != 0)
     {
-        const auto key = [&]()
+        if (lua_type(STATE, -2) == LUA_TNUMBER)
+        {
+            // Already read in above
+            const auto index = lua_tonumber(STATE, -2);
+            if (index >= 1 && index <= length && index == (std::size_t)index)
+            {
+                lua_pop(STATE, 1);
+                continue;
+            }
+        }
+
+        auto key = [&]()
         {
             switch (lua_type(STATE, -2))
             {
@@ -64,42 +143,48 @@ Table::Table(State L)
             }
         }();
         
-        std::shared_ptr<void> value;
-
-        const auto count = lua_gettop(STATE);
-        const auto type = lua_type(STATE, -1);
-        switch(type)
-        {
-        case LUA_TNUMBER:   value = Data::emplace(static_cast<Lua::Number>(lua_tonumber(STATE, -1))); break;
-        case LUA_TSTRING:   value = Data::emplace(Lua::String(lua_tostring(STATE, -1)));              break;
-        case LUA_TBOOLEAN:  value = Data::emplace(lua_toboolean(STATE, -1));                          break;
-        case LUA_TUSERDATA: value = Data::emplace(lua_touserdata(STATE, -1));                         break;
-        case LUA_TTABLE:    value = Data::emplace(Table(STATE)); break;
-        }
-        
-        dictionary.insert(std::pair(key, Data{ .data = value, .type = type }));
-        if (count == lua_gettop(STATE)) lua_pop(STATE, 1);
+        dictionary.emplace_back(std::move(key), dataFromStack(L));
     }
     lua_pop(STATE, 1);
 }
 
+Table::Data*
+Table::_find(const std::string& name)
+{
+    for (auto& p : dictionary)
+        if (p.first == name) return &p.second;
+    return nullptr;
+}
+
+const Table::Data*
+Table::_find(const std::string& name) const
+{
+    for (const auto& p : dictionary)
+        if (p.first == name) return &p.second;
+    return nullptr;
+}
+
+void
+Table::_insert(const std::string& name, Data&& data)
+{
+    if (auto* existing = _find(name)) *existing = std::move(data);
+    else dictionary.emplace_back(name, std::move(data));
+}
+
 const Table::Data& 
 Table::getRaw(const std::string& name) const
 {
-    S2D_ASSERT_ARGS(dictionary.count(name), "Error requesting raw data \"%s\"", name.c_str());
-    return dictionary.at(name);
+    const auto* data = _find(name);
+    S2D_ASSERT_ARGS(data, "Error requesting raw data \"%s\"", name.c_str());
+    return *data;
 }
 
 template<typename T>
 void 
 Table::each(std::function<void(uint32_t, T&)> lambda)
 {
-    uint32_t i = 1;
-    while (hasValue(std::to_string(i)))
-    {
-        auto& val = get<T>(std::to_string(i));
-        lambda(i++, val);
-    }
+    for (uint32_t i = 1; i <= array.size(); i++)
+        lambda(i, get<T>(i));
 }
 template void Table::each(std::function<void(uint32_t, Lua::Number&)>);
 template void Table::each(std::function<void(uint32_t, Lua::String&)>);
@@ -112,12 +197,8 @@ template<typename T>
 void 
 Table::each(std::function<void(uint32_t, const T&)> lambda) const
 {
-    uint32_t i = 1;
-    while (hasValue(std::to_string(i)))
-    {
-        const auto& val = get<T>(std::to_string(i));
-        lambda(i++, val);
-    }
+    for (uint32_t i = 1; i <= array.size(); i++)
+        lambda(i, get<T>(i));
 }
 template void Table::each(std::function<void(uint32_t, const Lua::Number&)>) const;
 template void Table::each(std::function<void(uint32_t, const Lua::String&)>) const;
@@ -153,6 +234,7 @@ template void Table::try_get(const std::string&, std::function<void(void* const&
 void
 Table::fromTable(const Table& table)
 {
+    array      = table.array;
     dictionary = table.dictionary;
 }
 
@@ -165,20 +247,22 @@ Table::superimpose(const Table& table)
 void 
 Table::superimpose(const Map& map)
 {
+    dictionary.reserve(dictionary.size() + map.size());
     for (const auto& p : map)
-        dictionary.insert(p);
+        if (!_find(p.first)) dictionary.push_back(p);
 }
 
 bool Table::hasValue(const std::string& name) const
 {
-    return dictionary.count(name);
+    return _find(name);
 }
 
 template<typename T>
 T& Table::get(const std::string& name)
 {
-    S2D_ASSERT(dictionary.count(name), "Dictionary doesn't have key");
-    return *static_cast<T*>(dictionary.at(name).data.get());
+    auto* data = _find(name);
+    S2D_ASSERT(data, "Dictionary doesn't have key");
+    return valueOf<T>(data->value);
 }
 template Lua::Number&   Table::get(const std::string&);
 template Lua::String&   Table::get(const std::string&);
@@ -190,8 +274,9 @@ template void**&        Table::get(const std::string&);
 template<typename T>
 const T& Table::get(const std::string& name) const
 {
-    S2D_ASSERT(dictionary.count(name), "Dictionary doesn't have key");
-    return *static_cast<T*>(dictionary.at(name).data.get());
+    const auto* data = _find(name);
+    S2D_ASSERT(data, "Dictionary doesn't have key");
+    return valueOf<T>(data->value);
 }
 template const Lua::Number&   Table::get(const std::string&) const;
 template const Lua::String&   Table::get(const std::string&) const;
@@ -199,11 +284,40 @@ template const Lua::Boolean&  Table::get(const std::string&) const;
 template const Lua::Function& Table::get(const std::string&) const;
 template const Lua::Table&    Table::get(const std::string&) const;
 template void** const&        Table::get(const std::string&) const;
+template void* const&         Table::get(const std::string&) const;
+
+template<typename T>
+T& Table::get(uint32_t index)
+{
+    S2D_ASSERT(index >= 1 && index <= array.size(), "Array index out of range");
+    return valueOf<T>(array[index - 1].value);
+}
+template Lua::Number&   Table::get(uint32_t);
+template Lua::String&   Table::get(uint32_t);
+template Lua::Boolean&  Table::get(uint32_t);
+template Lua::Function& Table::get(uint32_t);
+template Lua::Table&    Table::get(uint32_t);
+template void*&         Table::get(uint32_t);
+template void**&        Table::get(uint32_t);
+
+template<typename T>
+const T& Table::get(uint32_t index) const
+{
+    S2D_ASSERT(index >= 1 && index <= array.size(), "Array index out of range");
+    return valueOf<T>(array[index - 1].value);
+}
+template const Lua::Number&   Table::get(uint32_t) const;
+template const Lua::String&   Table::get(uint32_t) const;
+template const Lua::Boolean&  Table::get(uint32_t) const;
+template const Lua::Function& Table::get(uint32_t) const;
+template const Lua::Table&    Table::get(uint32_t) const;
+template void* const&         Table::get(uint32_t) const;
+template void** const&        Table::get(uint32_t) const;
 
 template<typename T>
 void Table::set(const std::string& name, const T& value)
 {
-    dictionary.insert(std::pair(name, Table::Data::fromValue(value)));
+    _insert(name, Table::Data::fromValue(value));
 }
 template void Table::set(const std::string&, const Lua::Number&);
 template void Table::set(const std::string&, const Lua::String&);
@@ -213,7 +327,39 @@ template void Table::set(const std::string&, const Lua::Table&);
 
 void Table::set(const std::string& name, void* value)
 {
-    dictionary.insert(std::pair(name, Table::Data::fromValue(value)));
+    _insert(name, Table::Data::fromValue(value));
+}
+
+template<typename T>
+void Table::push(const T& value)
+{
+    array.push_back(Table::Data::fromValue(value));
+}
+template void Table::push(const Lua::Number&);
+template void Table::push(const Lua::String&);
+template void Table::push(const Lua::Boolean&);
+template void Table::push(const Lua::Function&);
+template void Table::push(const Lua::Table&);
+
+void Table::push(void* value)
+{
+    array.push_back(Table::Data::fromValue(value));
+}
+
+std::size_t Table::size() const
+{
+    return array.size();
+}
+
+void Table::reserve(std::size_t count)
+{
+    dictionary.reserve(count);
+}
+
+void Table::reserve(std::size_t array_count, std::size_t count)
+{
+    array.reserve(array_count);
+    dictionary.reserve(count);
 }
 
 const Table::Map&
@@ -223,30 +369,18 @@ Table::getMap() const
 void
 Table::toStack(State L) const
 {
-    using namespace CompileTime;
+    lua_createtable(STATE, array.size(), dictionary.size());
 
-    lua_newtable(STATE);
+    for (std::size_t i = 0; i < array.size(); i++)
+        if (dataToStack(L, array[i])) lua_rawseti(STATE, -2, i + 1);
 
     for (const auto& p : dictionary)
     {
-        lua_pushstring(STATE, p.first.c_str());
-
-        switch (p.second.type)
-        {
-        case LUA_TNUMBER:  TypeMap<Lua::Number> ::push(L, get<Lua::Number> (p.first)); break;
-        case LUA_TSTRING:  TypeMap<Lua::String> ::push(L, get<Lua::String> (p.first)); break;
-        case LUA_TBOOLEAN: TypeMap<Lua::Boolean>::push(L, get<Lua::Boolean>(p.first)); break;
-        case LUA_TTABLE:
-        {
-            const auto& table = get<Lua::Table>(p.first);
-            table.toStack(L);
-            break;
-        }
-        case LUA_TFUNCTION: TypeMap<Lua::Function>::push(L, get<Lua::Function>(p.first)); break;
-        default: TypeMap<void*>::push(L, get<void*>(p.first)); break; // Worried about this... everywhere else needs void** so why does void* work?
-        }
+        if (std::holds_alternative<std::monostate>(p.second.value)) continue;
 
-        lua_settable(STATE, -3);
+        lua_pushlstring(STATE, p.first.c_str(), p.first.size());
+        dataToStack(L, p.second);
+        lua_rawset(STATE, -3);
     }
 }
 
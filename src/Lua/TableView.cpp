@@ -0,0 +1,134 @@
+#include <Simple2D/Lua/TableView.hpp>
+#include <Simple2D/Def.hpp>
+
+#include "Lua.cpp"
+
+namespace S2D::Lua
+{
+
+TableView::TableView(State L, int index) :
+    L(L),
+    _index(lua_absindex(STATE, index))
+{
+    S2D_ASSERT(lua_istable(STATE, _index), "Viewed value is not a table");
+}
+
+template<typename T>
+ViewType<T>
+TableView::_take(int type) const
+{
+    if constexpr (std::is_same_v<T, Lua::Table>)
+    {
+        S2D_ASSERT(type == LUA_TTABLE, "Table value type mismatch");
+        return TableView(L, -1);
+    }
+    else
+    {
+        T value;
+        if constexpr (std::is_same_v<T, Lua::Number>)
+        {
+            S2D_ASSERT(type == LUA_TNUMBER, "Table value type mismatch");
+            value = static_cast<Lua::Number>(lua_tonumber(STATE, -1));
+        }
+        else if constexpr (std::is_same_v<T, Lua::Boolean>)
+        {
+            S2D_ASSERT(type == LUA_TBOOLEAN, "Table value type mismatch");
+            value = lua_toboolean(STATE, -1);
+        }
+        else if constexpr (std::is_same_v<T, Lua::String>)
+        {
+            S2D_ASSERT(type == LUA_TSTRING, "Table value type mismatch");
+            std::size_t length;
+            const char* string = lua_tolstring(STATE, -1, &length);
+            value.assign(string, length);
+        }
+        else if constexpr (std::is_same_v<T, Lua::Function>)
+        {
+            S2D_ASSERT(type == LUA_TFUNCTION, "Table value type mismatch");
+            value = (Lua::Function)lua_tocfunction(STATE, -1);
+        }
+        else
+        {
+            // Same as Table, userdata is handed back as the address of the block
+            S2D_ASSERT(type == LUA_TUSERDATA, "Table value type mismatch");
+            value = reinterpret_cast<T>(lua_touserdata(STATE, -1));
+        }
+
+        lua_pop(STATE, 1);
+        return value;
+    }
+}
+
+template<typename T>
+ViewType<T>
+TableView::get(const std::string& name) const
+{
+    luaL_checkstack(STATE, 1, "Table view");
+    return _take<T>(lua_getfield(STATE, _index, name.c_str()));
+}
+template Lua::Number  TableView::get<Lua::Number> (const std::string&) const;
+template Lua::String  TableView::get<Lua::String> (const std::string&) const;
+template Lua::Boolean TableView::get<Lua::Boolean>(const std::string&) const;
+template Lua::Function TableView::get<Lua::Function>(const std::string&) const;
+template TableView    TableView::get<Lua::Table>  (const std::string&) const;
+template void*        TableView::get<void*>       (const std::string&) const;
+template void**       TableView::get<void**>      (const std::string&) const;
+
+template<typename T>
+ViewType<T>
+TableView::get(uint32_t index) const
+{
+    luaL_checkstack(STATE, 1, "Table view");
+    return _take<T>(lua_rawgeti(STATE, _index, index));
+}
+template Lua::Number  TableView::get<Lua::Number> (uint32_t) const;
+template Lua::String  TableView::get<Lua::String> (uint32_t) const;
+template Lua::Boolean TableView::get<Lua::Boolean>(uint32_t) const;
+template Lua::Function TableView::get<Lua::Function>(uint32_t) const;
+template TableView    TableView::get<Lua::Table>  (uint32_t) const;
+template void*        TableView::get<void*>       (uint32_t) const;
+template void**       TableView::get<void**>      (uint32_t) const;
+
+template<typename T>
+void
+TableView::try_get(const std::string& name, std::function<void(const ViewType<T>&)> lambda) const
+{
+    luaL_checkstack(STATE, 1, "Table view");
+    const int type = lua_getfield(STATE, _index, name.c_str());
+    if (type == LUA_TNIL)
+    {
+        lua_pop(STATE, 1);
+        return;
+    }
+    lambda(_take<T>(type));
+}
+template void TableView::try_get<Lua::Number> (const std::string&, std::function<void(const Lua::Number&)>) const;
+template void TableView::try_get<Lua::String> (const std::string&, std::function<void(const Lua::String&)>) const;
+template void TableView::try_get<Lua::Boolean>(const std::string&, std::function<void(const Lua::Boolean&)>) const;
+template void TableView::try_get<Lua::Table>  (const std::string&, std::function<void(const TableView&)>) const;
+template void TableView::try_get<void*>       (const std::string&, std::function<void(void* const&)>) const;
+template void TableView::try_get<void**>      (const std::string&, std::function<void(void** const&)>) const;
+
+bool
+TableView::hasValue(const std::string& name) const
+{
+    luaL_checkstack(STATE, 1, "Table view");
+    const bool has = (lua_getfield(STATE, _index, name.c_str()) != LUA_TNIL);
+    lua_pop(STATE, 1);
+    return has;
+}
+
+std::size_t
+TableView::size() const
+{
+    return lua_rawlen(STATE, _index);
+}
+
+Table
+TableView::toTable() const
+{
+    lua_pushvalue(STATE, _index);
+    return Table(L);
+}
+
+} // S2D::Lua
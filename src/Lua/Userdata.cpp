@@ -0,0 +1,68 @@
+#include <Simple2D/Lua/Userdata.hpp>
+
+#include "Lua.cpp"
+
+namespace S2D::Lua
+{
+
+namespace detail
+{
+    void* __pushUserdata(State L, const char* type_name, std::size_t size)
+    {
+        void* block = lua_newuserdata(STATE, size);
+        luaL_setmetatable(STATE, type_name);
+        return block;
+    }
+
+    void* __pushCachedUserdata(State L, const char* type_name, int64_t key, std::size_t size)
+    {
+        // Each type gets its own cache table in the registry, keyed by the type name
+        if (luaL_getmetatable(STATE, type_name) == LUA_TNIL)
+        {
+            lua_pop(STATE, 1);
+            luaL_newmetatable(STATE, type_name);
+        }
+
+        if (lua_rawgetp(STATE, LUA_REGISTRYINDEX, lua_topointer(STATE, -1)) != LUA_TTABLE)
+        {
+            lua_pop(STATE, 1);
+            lua_newtable(STATE);
+
+            // Weak values, so handles of destroyed objects don't pile up in long lived runtimes
+            lua_createtable(STATE, 0, 1);
+            lua_pushstring(STATE, "v");
+            lua_setfield(STATE, -2, "__mode");
+            lua_setmetatable(STATE, -2);
+
+            lua_pushvalue(STATE, -1);
+            lua_rawsetp(STATE, LUA_REGISTRYINDEX, lua_topointer(STATE, -3));
+        }
+
+        // Stack: metatable, cache
+        if (lua_rawgeti(STATE, -1, key) == LUA_TUSERDATA)
+        {
+            lua_insert(STATE, -3);
+            lua_pop(STATE, 2);
+            return lua_touserdata(STATE, -1);
+        }
+        lua_pop(STATE, 1);
+
+        void* block = lua_newuserdata(STATE, size);
+        lua_pushvalue(STATE, -3);
+        lua_setmetatable(STATE, -2);
+        lua_pushvalue(STATE, -1);
+        lua_rawseti(STATE, -3, key);
+
+        // Leave only the userdata on the stack
+        lua_insert(STATE, -3);
+        lua_pop(STATE, 2);
+        return block;
+    }
+
+    void* __testUserdata(State L, const char* type_name, int index)
+    {
+        return luaL_testudata(STATE, index, type_name);
+    }
+}
+
+} // S2D::Lua